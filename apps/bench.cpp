@@ -0,0 +1,448 @@
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "chess/core/board.hpp"
+#include "chess/core/rules.hpp"
+#include "chess/engine/eval.hpp"
+#include "chess/engine/pawns.hpp"
+#include "chess/engine/search.hpp"
+#include "chess/engine/tt.hpp"
+#include "chess/parser/fen.hpp"
+
+using namespace chess;
+using Clock = std::chrono::steady_clock;
+
+// Ray-walking slider attacks as they were before the magic tables.
+// Kept here only as the baseline the lookups are measured against.
+static Bitboard legacy_bishop_attacks(uint8_t square, Bitboard occupied)
+{
+    Bitboard attacks = 0;
+    int rank = square / 8;
+    int file = square % 8;
+
+    for (int r = rank + 1, f = file + 1; r < 8 && f < 8; r++, f++)
+    {
+        attacks |= 1ULL << (r * 8 + f);
+        if (occupied & (1ULL << (r * 8 + f)))
+            break;
+    }
+    for (int r = rank + 1, f = file - 1; r < 8 && f >= 0; r++, f--)
+    {
+        attacks |= 1ULL << (r * 8 + f);
+        if (occupied & (1ULL << (r * 8 + f)))
+            break;
+    }
+    for (int r = rank - 1, f = file + 1; r >= 0 && f < 8; r--, f++)
+    {
+        attacks |= 1ULL << (r * 8 + f);
+        if (occupied & (1ULL << (r * 8 + f)))
+            break;
+    }
+    for (int r = rank - 1, f = file - 1; r >= 0 && f >= 0; r--, f--)
+    {
+        attacks |= 1ULL << (r * 8 + f);
+        if (occupied & (1ULL << (r * 8 + f)))
+            break;
+    }
+
+    return attacks;
+}
+
+static Bitboard legacy_rook_attacks(uint8_t square, Bitboard occupied)
+{
+    Bitboard attacks = 0;
+    int rank = square / 8;
+    int file = square % 8;
+
+    for (int r = rank + 1; r < 8; r++)
+    {
+        attacks |= 1ULL << (r * 8 + file);
+        if (occupied & (1ULL << (r * 8 + file)))
+            break;
+    }
+    for (int r = rank - 1; r >= 0; r--)
+    {
+        attacks |= 1ULL << (r * 8 + file);
+        if (occupied & (1ULL << (r * 8 + file)))
+            break;
+    }
+    for (int f = file + 1; f < 8; f++)
+    {
+        attacks |= 1ULL << (rank * 8 + f);
+        if (occupied & (1ULL << (rank * 8 + f)))
+            break;
+    }
+    for (int f = file - 1; f >= 0; f--)
+    {
+        attacks |= 1ULL << (rank * 8 + f);
+        if (occupied & (1ULL << (rank * 8 + f)))
+            break;
+    }
+
+    return attacks;
+}
+
+static double elapsed_ns(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Random occupancies with a realistic density (~25% of squares filled)
+static std::vector<Bitboard> make_occupancies(size_t count)
+{
+    std::vector<Bitboard> occ(count);
+    uint64_t s = 0x2545F4914F6CDD1DULL;
+    auto next = [&s]()
+    {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    };
+    for (auto &o : occ)
+        o = next() & next();
+    return occ;
+}
+
+template <typename F>
+static double time_slider(F attacks, const std::vector<Bitboard> &occ, int rounds, Bitboard &sink)
+{
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < occ.size(); ++i)
+            sink ^= attacks(static_cast<uint8_t>(i & 63), occ[i]);
+    return elapsed_ns(start) / (double(rounds) * occ.size());
+}
+
+// Times one backend on its own scratch tables, next to the engine's tables
+template <SliderBackend Backend>
+static void bench_slider_backend(const std::vector<Bitboard> &occ, int rounds, Bitboard &sink,
+                                 double legacy_rook, double legacy_bishop)
+{
+    if (!slider_backend_supported(Backend))
+        return;
+
+    static Magic rook_magics[64], bishop_magics[64];
+    std::vector<Bitboard> storage(SLIDER_TABLE_SIZE);
+    fill_slider_tables(Backend, rook_magics, bishop_magics, storage.data());
+
+    auto rook_lookup = [](uint8_t square, Bitboard occupied)
+    {
+        const Magic &m = rook_magics[square];
+        return m.attacks[m.index<Backend>(occupied)];
+    };
+    auto bishop_lookup = [](uint8_t square, Bitboard occupied)
+    {
+        const Magic &m = bishop_magics[square];
+        return m.attacks[m.index<Backend>(occupied)];
+    };
+
+    double rook = time_slider(rook_lookup, occ, rounds, sink);
+    double bishop = time_slider(bishop_lookup, occ, rounds, sink);
+    std::cout << "  " << std::left << std::setw(16) << slider_backend_name(Backend) << std::right
+              << " rook " << std::setw(7) << rook << " (x" << legacy_rook / rook << ")"
+              << "  bishop " << std::setw(7) << bishop << " (x" << legacy_bishop / bishop << ")"
+              << (Backend == SLIDER_BACKEND ? "  <- built in" : "") << "\n";
+}
+
+static void bench_sliders()
+{
+    const auto occ = make_occupancies(1 << 16);
+    const int rounds = 50;
+    Bitboard sink = 0;
+
+    std::cout << "Slider attacks (ns/call):\n";
+
+    double legacy_rook = time_slider(legacy_rook_attacks, occ, rounds, sink);
+    double legacy_bishop = time_slider(legacy_bishop_attacks, occ, rounds, sink);
+    std::cout << "  loop             rook " << std::setw(7) << legacy_rook
+              << "  bishop " << std::setw(7) << legacy_bishop << "\n";
+
+    bench_slider_backend<SliderBackend::MAGIC>(occ, rounds, sink, legacy_rook, legacy_bishop);
+    bench_slider_backend<SliderBackend::PEXT>(occ, rounds, sink, legacy_rook, legacy_bishop);
+
+    double rook = time_slider([](uint8_t sq, Bitboard o) { return get_rook_attacks(sq, o); }, occ, rounds, sink);
+    double bishop = time_slider([](uint8_t sq, Bitboard o) { return get_bishop_attacks(sq, o); }, occ, rounds, sink);
+    std::cout << "  engine           rook " << std::setw(7) << rook << "  bishop " << std::setw(7) << bishop << "\n";
+
+    if (sink == 42)
+        std::cout << "";
+}
+
+static void bench_movegen()
+{
+    BoardState board;
+    init_board(board);
+
+    const int iterations = 200000;
+    MoveList moves;
+    uint64_t generated = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        generate_legal_moves(board, moves);
+        generated += moves.size();
+    }
+    double ns = elapsed_ns(start);
+
+    std::cout << "Legal movegen (startpos): " << std::setw(7) << ns / iterations << " ns/position, "
+              << uint64_t(generated * 1e9 / ns) << " moves/s\n";
+}
+
+// Terminal detection as check_game_result used to do it, against the
+// early-exit test, plus counting without a move list
+static void bench_legal_count()
+{
+    BoardState board;
+    init_board(board);
+    auto kiwipete = parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    if (kiwipete)
+        board = *kiwipete;
+
+    const int iterations = 200000;
+    MoveList moves;
+    uint64_t sink = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        generate_legal_moves(board, moves);
+        sink += moves.empty();
+    }
+    double list_ns = elapsed_ns(start) / iterations;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+        sink += has_any_legal_move(board);
+    double any_ns = elapsed_ns(start) / iterations;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+        sink += count_legal_moves(board);
+    double count_ns = elapsed_ns(start) / iterations;
+
+    // Validating one hash or killer move, as the move picker does, over a
+    // mix of legal moves and moves from another position
+    std::vector<Move> candidates(moves.begin(), moves.end());
+    MoveList foreign;
+    BoardState start_board;
+    init_board(start_board);
+    generate_legal_moves(start_board, foreign);
+    candidates.insert(candidates.end(), foreign.begin(), foreign.end());
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+        sink += is_legal_move(board, candidates[i % candidates.size()]);
+    double validate_ns = elapsed_ns(start) / iterations;
+
+    std::cout << "Legal moves (kiwipete): list " << std::setw(6) << list_ns << " ns, has_any "
+              << std::setw(6) << any_ns << " ns, count " << std::setw(6) << count_ns << " ns, validate one "
+              << std::setw(6) << validate_ns << " ns\n";
+    if (sink == 42)
+        std::cout << "";
+}
+
+// Material + PST the way it has to be done without the running sums:
+// visit every piece on every call.
+static int32_t rescan_material_pst(const BoardState &board)
+{
+    int32_t mg = 0, eg = 0;
+    int phase = 0;
+    Bitboard occupied = board.occupied;
+    while (occupied)
+    {
+        uint8_t sq = pop_lsb(occupied);
+        uint8_t piece = piece_at(board, sq);
+        mg += PSQT_MG[piece][sq];
+        eg += PSQT_EG[piece][sq];
+        phase += PHASE_WEIGHTS[piece];
+    }
+    phase = phase < psqt::PHASE_MAX ? phase : psqt::PHASE_MAX;
+    int32_t score = (mg * phase + eg * (psqt::PHASE_MAX - phase)) / psqt::PHASE_MAX;
+    return board.side_to_move == WHITE ? score : -score;
+}
+
+static void bench_eval()
+{
+    auto board = parse_fen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+    const int iterations = 2000000;
+    int64_t sink = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        board->side_to_move = static_cast<Color>(i & 1);
+        sink += rescan_material_pst(*board);
+    }
+    double rescan = elapsed_ns(start) / iterations;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        board->side_to_move = static_cast<Color>(i & 1);
+        sink += evaluate(*board);
+    }
+    double incremental = elapsed_ns(start) / iterations;
+
+    std::cout << "Material+PST eval (ns/call): rescan " << rescan << ", evaluate() " << incremental
+              << " incl. pawn hash (x" << rescan / incremental << ")\n";
+    if (sink == 42)
+        std::cout << "";
+}
+
+// Evaluates every node of a small tree, as a search would at its leaves
+static uint64_t eval_tree(BoardState &board, int depth, bool use_table, int64_t &sink)
+{
+    sink += use_table ? evaluate_pawn_structure(board) : evaluate_pawns(board).mg;
+    if (depth == 0)
+        return 1;
+
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    uint64_t nodes = 1;
+    for (Move m : moves)
+    {
+        UndoInfo undo;
+        make_move(board, m, undo);
+        nodes += eval_tree(board, depth - 1, use_table, sink);
+        unmake_move(board, m, undo);
+    }
+    return nodes;
+}
+
+static void bench_pawn_hash()
+{
+    auto board = parse_fen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+    PawnTable &table = thread_pawn_table();
+    table.clear();
+    int64_t sink = 0;
+
+    auto start = Clock::now();
+    uint64_t nodes = eval_tree(*board, 3, false, sink);
+    double direct = elapsed_ns(start) / nodes;
+
+    start = Clock::now();
+    eval_tree(*board, 3, true, sink);
+    double cached = elapsed_ns(start) / nodes;
+
+    std::cout << "Pawn structure (ns/node incl. movegen): direct " << direct << ", hashed " << cached
+              << ", hit rate " << 100.0 * table.hits / table.probes << "%\n";
+    if (sink == 42)
+        std::cout << "";
+}
+
+// Fixed-depth search over a few positions; the reference for search tuning
+static void bench_search()
+{
+    const char *positions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    SearchLimits limits;
+    limits.max_depth = 7;
+
+    uint64_t nodes = 0;
+    double ms = 0;
+    for (const char *fen : positions)
+    {
+        auto board = parse_fen(fen);
+        if (!board)
+            continue;
+        SearchResult result = search(*board, limits);
+        nodes += result.nodes_searched;
+        ms += result.time_elapsed.count();
+    }
+
+    std::cout << "Search (depth " << limits.max_depth << ", 4 positions): " << nodes << " nodes, " << ms
+              << " ms, " << uint64_t(nodes / std::max(ms, 1.0) * 1000) << " nps\n";
+}
+
+// Lazy SMP time-to-depth: the same fixed-depth search with 1, 2, 4, ...
+// threads, each run starting from an empty transposition table
+static void bench_smp_scaling(int max_threads, uint32_t depth)
+{
+    const char *fen = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    auto board = parse_fen(fen);
+    if (!board)
+        return;
+
+    std::cout << "SMP time-to-depth (depth " << depth << ", hardware threads "
+              << std::thread::hardware_concurrency() << ")\n";
+    std::cout << "threads    nodes        ms      nps          speedup  efficiency  move\n";
+
+    TranspositionTable tt;
+    tt.resize(TranspositionTable::DEFAULT_MB);
+    double base_ms = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        tt.clear();
+        SearchLimits limits;
+        limits.max_depth = depth;
+        limits.threads = threads;
+        SearchResult result = search(*board, limits, MoveStack{}, tt);
+
+        double ms = std::max(double(result.time_elapsed.count()), 1.0);
+        if (threads == 1)
+            base_ms = ms;
+        double speedup = base_ms / ms;
+        std::cout << std::left << std::setw(11) << threads << std::setw(13) << result.nodes_searched
+                  << std::setw(8) << ms << std::setw(13) << uint64_t(result.nodes_searched / ms * 1000)
+                  << std::setw(9) << speedup << std::setw(12) << speedup / threads
+                  << move_to_string(*board, result.best_move) << std::right << "\n";
+    }
+}
+
+// Wall time of whole short-lived processes that only touch the attack tables,
+// which is what batch jobs pay per engine start.
+static void bench_startup(const char *self)
+{
+    const int runs = 20;
+    const std::string probe = std::string("\"") + self + "\" --startup-probe";
+
+    auto start = Clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        if (std::system(probe.c_str()) != 0)
+        {
+            std::cout << "Startup: probe process failed\n";
+            return;
+        }
+    }
+    double process_ms = elapsed_ns(start) / 1e6 / runs;
+
+    std::cout << "Startup: " << process_ms << " ms/process (all attack tables compile-time)\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--startup-probe")
+        return get_knight_attacks(0) && get_rook_attacks(0, 0) && BETWEEN[0][63] ? 0 : 1;
+
+    std::cout << std::fixed << std::setprecision(2);
+    if (argc > 1 && std::string(argv[1]) == "--smp-scaling")
+    {
+        int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+        uint32_t depth = argc > 3 ? uint32_t(std::atoi(argv[3])) : 9;
+        bench_smp_scaling(std::max(max_threads, 1), depth);
+        return 0;
+    }
+    std::cout << "Slider backend: " << slider_backend_name(SLIDER_BACKEND) << "\n";
+    bench_sliders();
+    bench_movegen();
+    bench_legal_count();
+    bench_eval();
+    bench_pawn_hash();
+    bench_search();
+    bench_startup(argv[0]);
+    return 0;
+}
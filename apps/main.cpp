@@ -6,6 +6,8 @@
 #include "chess/core/move.hpp"
 #include "chess/core/piece.hpp"
 #include "chess/core/rules.hpp"
+#include "chess/parser/fen.hpp"
+#include "chess/engine/search.hpp"
 
 using namespace chess;
 
@@ -87,19 +89,22 @@ int main()
 {
     BoardState board;
     set_starting_position(board);
+    MoveStack history; // moves since the last irreversible one, for repetitions
     std::string input;
 
     std::cout << "Chess Engine CLI\n";
+    std::cout << "Slider attacks: " << slider_backend_name(SLIDER_BACKEND) << "\n";
     std::cout << "Enter moves like 'e2e4' or 'e2 e4' or 'quit' to exit\n";
     std::cout << "Type 'moves' to see all legal moves\n";
-    std::cout << "Type 'fen' to see FEN position\n\n";
+    std::cout << "Type 'fen' to see FEN position\n";
+    std::cout << "Type 'go' to let the engine move\n\n";
 
     while (true)
     {
         render_board(board);
 
         // Check game status
-        GameResult result = check_game_result(board);
+        GameResult result = check_game_result(board, history);
         if (result == WHITE_WINS)
         {
             std::cout << "Game Over: Black is Checkmate - White Wins!\n";
@@ -115,13 +120,24 @@ int main()
             std::cout << "Game Over: Stalemate - Draw!\n";
             break;
         }
-
-        if (is_checkmate(board))
+        else if (result == DRAW_REPETITION)
+        {
+            std::cout << "Game Over: Threefold repetition - Draw!\n";
+            break;
+        }
+        else if (result == DRAW_FIFTY_MOVE)
+        {
+            std::cout << "Game Over: Fifty-move rule - Draw!\n";
+            break;
+        }
+        else if (result == DRAW_INSUFFICIENT)
         {
-            std::cout << "Checkmate!\n";
+            std::cout << "Game Over: Insufficient material - Draw!\n";
             break;
         }
-        else if (is_in_check(board))
+
+        // Mate was reported above, so a check here still has replies
+        if (is_in_check(board))
         {
             std::cout << "Check!\n";
         }
@@ -154,7 +170,22 @@ int main()
 
         if (input == "fen")
         {
-            std::cout << "FEN: (not implemented)\n";
+            std::cout << "FEN: " << board_to_fen(board) << "\n";
+            continue;
+        }
+
+        if (input == "go")
+        {
+            SearchLimits limits;
+            limits.max_time = std::chrono::seconds(2);
+            SearchResult result = search(board, limits, history);
+
+            std::cout << "Engine plays " << move_to_string(board, result.best_move) << " (depth " << result.depth
+                      << ", score " << result.score << ", " << result.nodes_searched << " nodes in "
+                      << result.time_elapsed.count() << " ms, hash " << default_tt().hashfull() / 10.0 << "%)\n";
+            make_move(board, result.best_move, history);
+            if (board.halfmove_clock == 0)
+                history.top = -1;
             continue;
         }
 
@@ -186,7 +217,10 @@ int main()
             continue;
         }
 
-        make_move(board, m);
+        make_move(board, m, history);
+        // Earlier positions can never recur, and the history stays bounded
+        if (board.halfmove_clock == 0)
+            history.top = -1;
     }
 
     return 0;
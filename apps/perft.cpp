@@ -0,0 +1,290 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include "chess/core/board.hpp"
+#include "chess/core/perft.hpp"
+#include "chess/parser/fen.hpp"
+
+using namespace chess;
+using Clock = std::chrono::steady_clock;
+
+// One EPD record: a position and the known leaf counts per depth
+struct PerftRecord
+{
+    std::string fen;
+    std::vector<std::pair<int, uint64_t>> expected; // (depth, nodes)
+};
+
+// The usual reference positions (chessprogramming.org "Perft Results")
+static const char *STANDARD_SUITE[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902 ;D4 197281 ;D5 4865609 ;D6 119060324",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ;D1 48 ;D2 2039 ;D3 97862 ;D4 4085603 ;D5 193690690",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 ;D2 191 ;D3 2812 ;D4 43238 ;D5 674624 ;D6 11030083 ;D7 178633661",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1 ;D1 6 ;D2 264 ;D3 9467 ;D4 422333 ;D5 15833292",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 ;D1 44 ;D2 1486 ;D3 62379 ;D4 2103487 ;D5 89941194",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10 ;D1 46 ;D2 2079 ;D3 89890 ;D4 3894594 ;D5 164075551",
+};
+
+// "<fen> ;D1 20 ;D2 400 ..." -- the format of the common perftsuite.epd files
+static bool parse_epd_record(const std::string &line, PerftRecord &record)
+{
+    std::istringstream fields(line);
+    std::string part;
+    if (!std::getline(fields, part, ';'))
+        return false;
+
+    record.fen = part;
+    record.expected.clear();
+
+    while (std::getline(fields, part, ';'))
+    {
+        std::istringstream ss(part);
+        std::string tag;
+        uint64_t nodes = 0;
+        if (!(ss >> tag >> nodes) || tag.size() < 2 || tag[0] != 'D')
+            continue;
+        record.expected.push_back({std::atoi(tag.c_str() + 1), nodes});
+    }
+    return true;
+}
+
+static double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void print_result(uint64_t nodes, double seconds)
+{
+    std::cout << "Nodes: " << nodes << "  Time: " << std::fixed << std::setprecision(3) << seconds
+              << " s  NPS: " << uint64_t(seconds > 0 ? nodes / seconds : 0) << "\n";
+}
+
+// Runs every record at each listed depth up to max_depth; false on any mismatch
+static bool run_suite(const std::vector<PerftRecord> &records, int max_depth, int threads, const PerftOptions &options)
+{
+    bool all_ok = true;
+    uint64_t total_nodes = 0;
+    auto suite_start = Clock::now();
+
+    for (const PerftRecord &record : records)
+    {
+        auto board = parse_fen(record.fen);
+        if (!board)
+        {
+            std::cout << "Invalid FEN: " << record.fen << "\n";
+            all_ok = false;
+            continue;
+        }
+
+        std::cout << record.fen << "\n";
+        for (const auto &[depth, expected] : record.expected)
+        {
+            if (depth > max_depth)
+                continue;
+            if (options.cache)
+                options.cache->clear();
+
+            auto start = Clock::now();
+            uint64_t nodes = perft_parallel(*board, depth, threads, options);
+            double seconds = seconds_since(start);
+            total_nodes += nodes;
+
+            bool ok = nodes == expected;
+            all_ok = all_ok && ok;
+            std::cout << "  D" << depth << " " << std::setw(12) << nodes << (ok ? "  OK  " : "  FAIL expected ")
+                      << (ok ? std::string() : std::to_string(expected) + "  ")
+                      << std::fixed << std::setprecision(3) << seconds << " s  "
+                      << uint64_t(seconds > 0 ? nodes / seconds : 0) << " nps\n";
+        }
+    }
+
+    std::cout << (all_ok ? "All counts match. " : "MISMATCH. ");
+    print_result(total_nodes, seconds_since(suite_start));
+    return all_ok;
+}
+
+// Same search at 1, 2, 4, ... threads. Efficiency is speedup / threads; a
+// drop that is not explained by the core count points at shared-state
+// contention in make_move or the generator.
+static bool run_scaling(const BoardState &board, int depth, int max_threads, const PerftOptions &options)
+{
+    std::vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n"
+              << "Threads        Nodes      Time           NPS  Speedup  Efficiency  Stolen\n";
+
+    double base_seconds = 0;
+    uint64_t base_nodes = 0;
+    bool deterministic = true;
+
+    for (int threads : counts)
+    {
+        if (options.cache)
+            options.cache->clear();
+
+        std::vector<PerftThreadStats> stats;
+        auto start = Clock::now();
+        uint64_t nodes = perft_parallel(board, depth, threads, options, &stats);
+        double seconds = seconds_since(start);
+
+        uint64_t stolen = 0;
+        for (const PerftThreadStats &s : stats)
+            stolen += s.stolen;
+
+        if (threads == 1)
+        {
+            base_seconds = seconds;
+            base_nodes = nodes;
+        }
+        deterministic = deterministic && nodes == base_nodes;
+
+        double speedup = seconds > 0 ? base_seconds / seconds : 0;
+        std::cout << std::fixed << std::setprecision(2) << std::setw(7) << threads << std::setw(13) << nodes
+                  << std::setw(9) << seconds << " s" << std::setw(14) << uint64_t(seconds > 0 ? nodes / seconds : 0)
+                  << std::setw(8) << speedup << "x" << std::setw(11) << 100.0 * speedup / threads << "%"
+                  << std::setw(8) << stolen << "\n";
+    }
+
+    std::cout << (deterministic ? "Node counts identical for every thread count\n"
+                                : "NODE COUNTS DIFFER BETWEEN THREAD COUNTS\n");
+    return deterministic;
+}
+
+static void usage()
+{
+    std::cout << "Usage: chess_perft [options]\n"
+                 "  --fen <FEN>      position to search (default: start position)\n"
+                 "  --depth <n>      search depth (default: 5)\n"
+                 "  --divide         print the leaf count below every root move\n"
+                 "  --epd <file>     verify every record of an EPD perft suite\n"
+                 "  --suite          verify the built-in reference suite\n"
+                 "  --max-depth <n>  deepest level checked in suite mode (default: 5)\n"
+                 "  --hash <MB>      size of the perft cache (default: 0, off)\n"
+                 "  --threads <n>    worker threads (default: 1)\n"
+                 "  --scaling        time 1, 2, 4, ... up to --threads workers\n"
+                 "  --no-bulk        visit the leaves instead of counting the last ply\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string fen = STARTING_FEN;
+    std::string epd_file;
+    int depth = 5;
+    int max_depth = 5;
+    size_t hash_mb = 0;
+    bool divide = false;
+    bool suite = false;
+    bool scaling = false;
+    int threads = 1;
+    PerftOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--fen" && has_value)
+            fen = argv[++i];
+        else if (arg == "--depth" && has_value)
+            depth = std::atoi(argv[++i]);
+        else if (arg == "--max-depth" && has_value)
+            max_depth = std::atoi(argv[++i]);
+        else if (arg == "--epd" && has_value)
+            epd_file = argv[++i];
+        else if (arg == "--hash" && has_value)
+            hash_mb = static_cast<size_t>(std::atoll(argv[++i]));
+        else if (arg == "--threads" && has_value)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--scaling")
+            scaling = true;
+        else if (arg == "--divide")
+            divide = true;
+        else if (arg == "--suite")
+            suite = true;
+        else if (arg == "--no-bulk")
+            options.bulk = false;
+        else
+        {
+            usage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    PerftCache cache;
+    if (hash_mb > 0)
+    {
+        cache.resize(hash_mb);
+        options.cache = &cache;
+    }
+
+    if (suite || !epd_file.empty())
+    {
+        std::vector<PerftRecord> records;
+        PerftRecord record;
+
+        if (suite)
+        {
+            for (const char *line : STANDARD_SUITE)
+                if (parse_epd_record(line, record))
+                    records.push_back(record);
+        }
+        else
+        {
+            std::ifstream in(epd_file);
+            if (!in)
+            {
+                std::cout << "Cannot open " << epd_file << "\n";
+                return 2;
+            }
+            std::string line;
+            while (std::getline(in, line))
+                if (!line.empty() && line[0] != '#' && parse_epd_record(line, record))
+                    records.push_back(record);
+        }
+
+        return run_suite(records, max_depth, threads, options) ? 0 : 1;
+    }
+
+    auto board = parse_fen(fen);
+    if (!board)
+    {
+        std::cout << "Invalid FEN: " << fen << "\n";
+        return 2;
+    }
+
+    if (scaling)
+        return run_scaling(*board, depth, threads, options) ? 0 : 1;
+
+    auto start = Clock::now();
+    uint64_t nodes = 0;
+
+    if (divide)
+    {
+        for (const PerftDivide &entry : perft_divide(*board, depth, options))
+        {
+            std::cout << move_to_string(*board, entry.move) << ": " << entry.nodes << "\n";
+            nodes += entry.nodes;
+        }
+        std::cout << "\n";
+    }
+    else
+    {
+        nodes = perft_parallel(*board, depth, threads, options);
+    }
+
+    print_result(nodes, seconds_since(start));
+    if (options.cache)
+        std::cout << "Cache hits: " << cache.hits << "\n";
+    return 0;
+}
@@ -0,0 +1,211 @@
+#ifndef CHESS_CORE_ATTACKS_HPP
+#define CHESS_CORE_ATTACKS_HPP
+
+#include "piece.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHESS_HAS_PEXT 1
+#if defined(__BMI2__) || defined(_MSC_VER)
+#include <immintrin.h>
+#endif
+#endif
+
+namespace chess
+{
+
+    using Bitboard = uint64_t;
+
+    enum class SliderBackend : uint8_t
+    {
+        MAGIC, // multiply-shift indexing, portable
+        PEXT   // BMI2 parallel bit extract, only where PEXT is fast
+    };
+
+    // Chosen at build time (cmake -DCHESS_PEXT=ON), so lookups stay a plain
+    // inline load. Magic is the default because it runs on every x86-64 CPU;
+    // a PEXT build needs BMI2 and is slow where PEXT is microcoded (AMD before
+    // Zen 3). chess_bench times both backends on the machine at hand.
+#if defined(CHESS_USE_PEXT) && defined(CHESS_HAS_PEXT)
+    constexpr SliderBackend SLIDER_BACKEND = SliderBackend::PEXT;
+#else
+    constexpr SliderBackend SLIDER_BACKEND = SliderBackend::MAGIC;
+#endif
+
+    bool slider_backend_supported(SliderBackend backend); // PEXT needs BMI2 (CPUID)
+    const char *slider_backend_name(SliderBackend backend);
+
+#ifdef CHESS_HAS_PEXT
+    inline Bitboard pext(Bitboard value, Bitboard mask)
+    {
+#if defined(__BMI2__) || defined(_MSC_VER)
+        return _pext_u64(value, mask);
+#else
+        // _pext_u64 would need -mbmi2 for the whole file; the instruction only
+        // runs after CPUID reported BMI2, so emit it directly instead.
+        Bitboard result;
+        asm("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+        return result;
+#endif
+    }
+#endif
+
+    // Fancy magic bitboards: every square has its own mask, magic and shift,
+    // and the attack sets of all squares live in one shared table.
+    struct Magic
+    {
+        Bitboard mask;
+        Bitboard magic;
+        const Bitboard *attacks;
+        unsigned shift;
+
+        template <SliderBackend Backend = SLIDER_BACKEND>
+        unsigned index(Bitboard occupied) const
+        {
+#ifdef CHESS_HAS_PEXT
+            if constexpr (Backend == SliderBackend::PEXT)
+                return static_cast<unsigned>(pext(occupied, mask));
+#endif
+            return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+        }
+    };
+
+    // Built at compile time for SLIDER_BACKEND
+    extern const std::array<Magic, 64> ROOK_MAGICS;
+    extern const std::array<Magic, 64> BISHOP_MAGICS;
+
+    // 102400 rook + 5248 bishop entries
+    constexpr size_t SLIDER_TABLE_SIZE = 107648;
+
+    // Lays out a set of slider tables for either backend in caller-owned
+    // storage of SLIDER_TABLE_SIZE entries, so the bench and the tests can
+    // compare the backends without touching the engine's own tables.
+    void fill_slider_tables(SliderBackend backend, Magic (&rook)[64], Magic (&bishop)[64], Bitboard *storage);
+
+    // Leaper and ray tables are built by the compiler, so they need no
+    // initialization pass and live in read-only data.
+    namespace detail
+    {
+        constexpr Bitboard shift_step(uint8_t square, int dr, int df)
+        {
+            int r = square / 8 + dr;
+            int f = square % 8 + df;
+            return (r >= 0 && r < 8 && f >= 0 && f < 8) ? 1ULL << (r * 8 + f) : 0;
+        }
+
+        constexpr std::array<Bitboard, 64> make_knight_attacks()
+        {
+            std::array<Bitboard, 64> table{};
+            constexpr int steps[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+            for (uint8_t sq = 0; sq < 64; ++sq)
+                for (const auto &s : steps)
+                    table[sq] |= shift_step(sq, s[0], s[1]);
+            return table;
+        }
+
+        constexpr std::array<Bitboard, 64> make_king_attacks()
+        {
+            std::array<Bitboard, 64> table{};
+            for (uint8_t sq = 0; sq < 64; ++sq)
+                for (int dr = -1; dr <= 1; ++dr)
+                    for (int df = -1; df <= 1; ++df)
+                        if (dr || df)
+                            table[sq] |= shift_step(sq, dr, df);
+            return table;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, 2> make_pawn_attacks()
+        {
+            std::array<std::array<Bitboard, 64>, 2> table{};
+            for (uint8_t sq = 0; sq < 64; ++sq)
+            {
+                table[WHITE][sq] = shift_step(sq, 1, -1) | shift_step(sq, 1, 1);
+                table[BLACK][sq] = shift_step(sq, -1, -1) | shift_step(sq, -1, 1);
+            }
+            return table;
+        }
+
+        constexpr int sign(int x) { return (x > 0) - (x < 0); }
+
+        // Direction from a to b if they share a rank, file or diagonal
+        constexpr bool aligned_step(uint8_t a, uint8_t b, int &dr, int &df)
+        {
+            int rd = b / 8 - a / 8;
+            int fd = b % 8 - a % 8;
+            if (a == b || (rd != 0 && fd != 0 && rd != fd && rd != -fd))
+                return false;
+            dr = sign(rd);
+            df = sign(fd);
+            return true;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, 64> make_between()
+        {
+            std::array<std::array<Bitboard, 64>, 64> table{};
+            for (uint8_t a = 0; a < 64; ++a)
+                for (uint8_t b = 0; b < 64; ++b)
+                {
+                    int dr = 0, df = 0;
+                    if (!aligned_step(a, b, dr, df))
+                        continue;
+                    for (int r = a / 8 + dr, f = a % 8 + df; r * 8 + f != b; r += dr, f += df)
+                        table[a][b] |= 1ULL << (r * 8 + f);
+                }
+            return table;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, 64> make_line()
+        {
+            std::array<std::array<Bitboard, 64>, 64> table{};
+            for (uint8_t a = 0; a < 64; ++a)
+                for (uint8_t b = 0; b < 64; ++b)
+                {
+                    int dr = 0, df = 0;
+                    if (!aligned_step(a, b, dr, df))
+                        continue;
+                    Bitboard line = 1ULL << a;
+                    for (int r = a / 8 + dr, f = a % 8 + df; r >= 0 && r < 8 && f >= 0 && f < 8; r += dr, f += df)
+                        line |= 1ULL << (r * 8 + f);
+                    for (int r = a / 8 - dr, f = a % 8 - df; r >= 0 && r < 8 && f >= 0 && f < 8; r -= dr, f -= df)
+                        line |= 1ULL << (r * 8 + f);
+                    table[a][b] = line;
+                }
+            return table;
+        }
+    } // namespace detail
+
+    inline constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = detail::make_knight_attacks();
+    inline constexpr std::array<Bitboard, 64> KING_ATTACKS = detail::make_king_attacks();
+    inline constexpr std::array<std::array<Bitboard, 64>, 2> PAWN_ATTACKS = detail::make_pawn_attacks();
+
+    // Squares strictly between two aligned squares, 0 otherwise
+    inline constexpr std::array<std::array<Bitboard, 64>, 64> BETWEEN = detail::make_between();
+    // Whole rank/file/diagonal through two aligned squares, 0 otherwise
+    inline constexpr std::array<std::array<Bitboard, 64>, 64> LINE = detail::make_line();
+
+    constexpr Bitboard get_pawn_attacks(uint8_t square, Color color) { return PAWN_ATTACKS[color][square]; }
+    constexpr Bitboard get_knight_attacks(uint8_t square) { return KNIGHT_ATTACKS[square]; }
+    constexpr Bitboard get_king_attacks(uint8_t square) { return KING_ATTACKS[square]; }
+
+    inline Bitboard get_bishop_attacks(uint8_t square, Bitboard occupied)
+    {
+        const Magic &m = BISHOP_MAGICS[square];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard get_rook_attacks(uint8_t square, Bitboard occupied)
+    {
+        const Magic &m = ROOK_MAGICS[square];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard get_queen_attacks(uint8_t square, Bitboard occupied)
+    {
+        return get_bishop_attacks(square, occupied) | get_rook_attacks(square, occupied);
+    }
+
+} // namespace chess
+
+#endif
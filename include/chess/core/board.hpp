@@ -3,32 +3,58 @@
 
 #include "piece.hpp"
 #include "move.hpp"
+#include "attacks.hpp"
+#include "psqt.hpp"
 #include <cstdint>
 #include <array>
+#include <type_traits>
 #include <optional>
 
 namespace chess
 {
 
-    using Bitboard = uint64_t;
-
     extern const std::array<std::array<uint64_t, 64>, 12> ZOBRIST_PIECES;
     extern const std::array<uint64_t, 16> ZOBRIST_CASTLING;
     extern const std::array<uint64_t, 8> ZOBRIST_EN_PASSANT;
     extern const uint64_t ZOBRIST_SIDE;
+    // Piece keys of pawns and kings, 0 for every other piece code
+    extern const std::array<std::array<uint64_t, 64>, 16> ZOBRIST_PAWN_KING;
+
+    // Material signature: the count of every non-king piece kind in its own
+    // 4-bit field (white P N B R Q, then black), so the key is exact and
+    // adding or removing a piece is a single add.
+    constexpr int material_shift(PieceType type, Color color) { return 4 * (type + 5 * color); }
+
+    inline constexpr std::array<uint64_t, 16> MATERIAL_KEY_DELTA = []
+    {
+        std::array<uint64_t, 16> deltas{};
+        for (Color color : {WHITE, BLACK})
+            for (int type = PAWN; type < KING; ++type)
+                deltas[make_piece(PieceType(type), color)] = 1ULL << material_shift(PieceType(type), color);
+        return deltas;
+    }();
+
+    constexpr int material_count(uint64_t material_key, PieceType type, Color color)
+    {
+        return (material_key >> material_shift(type, color)) & 0xF;
+    }
 
     struct UndoInfo
     {
         Move move;
+        uint8_t moved_piece;
         uint8_t captured_piece;
         uint8_t castling_rights;
         uint8_t en_passant_file;
         uint8_t halfmove_clock;
+        uint8_t side_to_move;
         uint64_t hash;
     };
 
     constexpr int MAX_MOVES = 1024;
 
+    // Undo history owned by the caller (game loop, search thread, perft),
+    // so that positions stay small and cheap to copy.
     struct MoveStack
     {
         UndoInfo stack[MAX_MOVES];
@@ -39,6 +65,11 @@ namespace chess
             stack[++top] = info;
         }
 
+        UndoInfo &push()
+        {
+            return stack[++top];
+        }
+
         UndoInfo pop()
         {
             return stack[top--];
@@ -55,6 +86,7 @@ namespace chess
         std::array<Bitboard, 6> pieces_bb; // Bitboards за всеки тип фигура
         std::array<Bitboard, 2> colors_bb; // Bitboards за всеки цвят
         Bitboard occupied;                 // Всички фигури
+        std::array<uint8_t, 64> mailbox;   // Фигура на всяко поле (NO_PIECE ако е празно)
 
         Color side_to_move;
         uint8_t castling_rights; // 4 bits: KQkq
@@ -62,13 +94,21 @@ namespace chess
         uint8_t halfmove_clock;
         uint16_t fullmove_number;
 
-        uint64_t hash; // Zobrist hash
+        int16_t psqt_mg; // Материал + PST за middlegame (бели минус черни)
+        int16_t psqt_eg; // Материал + PST за endgame
+        uint8_t phase;   // Сума на PHASE_WEIGHTS, 24 при пълен материал
 
-        MoveStack move_stack;
+        uint64_t hash;     // Zobrist hash
+        uint64_t pawn_key;     // Zobrist само на пешките и царете (за pawn hash table)
+        uint64_t material_key; // Брой фигури от всеки вид, по 4 бита (за material table)
 
         BoardState();
     };
 
+    // Search, perft and the legality checks copy positions by value
+    static_assert(std::is_trivially_copyable_v<BoardState>, "BoardState must stay trivially copyable");
+    static_assert(sizeof(BoardState) <= 176, "BoardState must stay within three cache lines");
+
     constexpr uint8_t CASTLE_WHITE_KING = 1 << 0;
     constexpr uint8_t CASTLE_WHITE_QUEEN = 1 << 1;
     constexpr uint8_t CASTLE_BLACK_KING = 1 << 2;
@@ -79,6 +119,63 @@ namespace chess
     constexpr Bitboard set_bit(Bitboard bb, uint8_t sq) { return bb | square_bb(sq); }
     constexpr Bitboard clear_bit(Bitboard bb, uint8_t sq) { return bb & ~square_bb(sq); }
 
+    inline uint64_t zobrist_piece_key(uint8_t piece, uint8_t square)
+    {
+        return ZOBRIST_PIECES[piece_type(piece) + 6 * piece_color(piece)][square];
+    }
+
+    inline uint8_t piece_at(const BoardState &board, uint8_t square)
+    {
+        return board.mailbox[square];
+    }
+
+    // Fast variants for when the caller already knows what is on the squares.
+    // They keep the piece part of the Zobrist hash, the pawn and material
+    // keys and the material/PST/phase sums up to date.
+    inline void put_piece(BoardState &board, uint8_t square, uint8_t piece) // square must be empty
+    {
+        Bitboard mask = square_bb(square);
+        board.pieces_bb[piece_type(piece)] |= mask;
+        board.colors_bb[piece_color(piece)] |= mask;
+        board.occupied |= mask;
+        board.mailbox[square] = piece;
+        board.hash ^= zobrist_piece_key(piece, square);
+        board.pawn_key ^= ZOBRIST_PAWN_KING[piece][square];
+        board.psqt_mg += PSQT_MG[piece][square];
+        board.psqt_eg += PSQT_EG[piece][square];
+        board.phase += PHASE_WEIGHTS[piece];
+        board.material_key += MATERIAL_KEY_DELTA[piece];
+    }
+
+    inline void remove_piece(BoardState &board, uint8_t square, uint8_t piece) // piece must be on square
+    {
+        Bitboard mask = square_bb(square);
+        board.pieces_bb[piece_type(piece)] &= ~mask;
+        board.colors_bb[piece_color(piece)] &= ~mask;
+        board.occupied &= ~mask;
+        board.mailbox[square] = NO_PIECE;
+        board.hash ^= zobrist_piece_key(piece, square);
+        board.pawn_key ^= ZOBRIST_PAWN_KING[piece][square];
+        board.psqt_mg -= PSQT_MG[piece][square];
+        board.psqt_eg -= PSQT_EG[piece][square];
+        board.phase -= PHASE_WEIGHTS[piece];
+        board.material_key -= MATERIAL_KEY_DELTA[piece];
+    }
+
+    inline void move_piece(BoardState &board, uint8_t from, uint8_t to, uint8_t piece) // to must be empty
+    {
+        Bitboard mask = square_bb(from) | square_bb(to);
+        board.pieces_bb[piece_type(piece)] ^= mask;
+        board.colors_bb[piece_color(piece)] ^= mask;
+        board.occupied ^= mask;
+        board.mailbox[from] = NO_PIECE;
+        board.mailbox[to] = piece;
+        board.hash ^= zobrist_piece_key(piece, from) ^ zobrist_piece_key(piece, to);
+        board.pawn_key ^= ZOBRIST_PAWN_KING[piece][from] ^ ZOBRIST_PAWN_KING[piece][to];
+        board.psqt_mg += PSQT_MG[piece][to] - PSQT_MG[piece][from];
+        board.psqt_eg += PSQT_EG[piece][to] - PSQT_EG[piece][from];
+    }
+
     int pop_count(Bitboard bb);
     int lsb(Bitboard bb);      // Least significant bit
     int msb(Bitboard bb);      // Most significant bit
@@ -87,22 +184,44 @@ namespace chess
     void init_board(BoardState &board);
     void reset_board(BoardState &board);
     void set_starting_position(BoardState &board);
-    uint8_t piece_at(const BoardState &board, uint8_t square);
     void place_piece(BoardState &board, uint8_t square, uint8_t piece);
     void remove_piece(BoardState &board, uint8_t square);
+
+    // make_move fills `undo`, unmake_move restores the position from it
+    void make_move(BoardState &board, Move move, UndoInfo &undo);
+    void unmake_move(BoardState &board, Move move, const UndoInfo &undo);
+
+    // Same, with the undo record kept on a caller-owned history
+    inline void make_move(BoardState &board, Move move, MoveStack &history)
+    {
+        make_move(board, move, history.push());
+    }
+
+    inline void unmake_move(BoardState &board, Move move, MoveStack &history)
+    {
+        unmake_move(board, move, history.stack[history.top--]);
+    }
+
+    // Original API: the undo record goes on the board's own history, kept
+    // outside BoardState in a per-thread table keyed by the board's address.
+    // A copy of a board starts with an empty history, and constructing or
+    // resetting a board clears it.
     void make_move(BoardState &board, Move move);
     void unmake_move(BoardState &board, Move move);
+    MoveStack &board_history(const BoardState &board);
 
-    Bitboard get_pawn_attacks(uint8_t square, Color color);
-    Bitboard get_knight_attacks(uint8_t square);
-    Bitboard get_king_attacks(uint8_t square);
-    Bitboard get_bishop_attacks(uint8_t square, Bitboard occupied);
-    Bitboard get_rook_attacks(uint8_t square, Bitboard occupied);
-    Bitboard get_queen_attacks(uint8_t square, Bitboard occupied);
+    // Plays a move that will never be taken back (game loops, parsers)
+    // without recording it anywhere
+    void play_move(BoardState &board, Move move);
 
     bool is_square_attacked(const BoardState &board, uint8_t square, Color by_color);
+    // Pieces of both colors attacking `square`, with sliders blocked by
+    // `occupied`. Passing a reduced occupancy reveals x-ray attackers.
+    Bitboard attackers_to(const BoardState &board, uint8_t square, Bitboard occupied);
     bool is_in_check(const BoardState &board);
     uint64_t compute_hash(const BoardState &board);
+    uint64_t compute_pawn_key(const BoardState &board);
+    uint64_t compute_material_key(const BoardState &board);
 
     std::string move_to_string(const BoardState &board, Move m);
     Move string_to_move(const BoardState &board, const std::string &str);
@@ -11,14 +11,20 @@ namespace chess
 
     // Bits 0-5: from square (0-63)
     // Bits 6-11: to square (0-63)
-    // Bits 12-13: promotion piece type (0-3 mapped to N,B,R,Q)
-    // Bits 14-15: special move flags (castle, en passant, etc)
-    struct BoardState;
-
+    // Bits 12-13: promotion piece type (0-3 mapped to N,B,R,Q), only with MOVE_PROMOTION
+    // Bits 14-15: special move flag (MoveFlag)
     using Move = uint16_t;
 
     constexpr uint16_t MOVE_NONE = 0;
 
+    enum MoveFlag : uint8_t
+    {
+        MOVE_NORMAL = 0,     // includes captures and double pushes
+        MOVE_PROMOTION = 1,
+        MOVE_EN_PASSANT = 2,
+        MOVE_CASTLING = 3    // encoded as the king's two-square step
+    };
+
     constexpr Move make_move(uint8_t from, uint8_t to)
     {
         return static_cast<Move>((to << 6) | from);
@@ -26,13 +32,49 @@ namespace chess
 
     constexpr Move make_promotion(uint8_t from, uint8_t to, uint8_t promo_type)
     {
-        return static_cast<Move>((promo_type << 12) | (to << 6) | from);
+        return static_cast<Move>((MOVE_PROMOTION << 14) | (promo_type << 12) | (to << 6) | from);
+    }
+
+    constexpr Move make_en_passant(uint8_t from, uint8_t to)
+    {
+        return static_cast<Move>((MOVE_EN_PASSANT << 14) | (to << 6) | from);
+    }
+
+    constexpr Move make_castling(uint8_t king_from, uint8_t king_to)
+    {
+        return static_cast<Move>((MOVE_CASTLING << 14) | (king_to << 6) | king_from);
     }
 
     constexpr uint8_t move_from(Move m) { return m & 0x3F; }
     constexpr uint8_t move_to(Move m) { return (m >> 6) & 0x3F; }
-    constexpr uint8_t move_promotion(Move m) { return (m >> 12) & 0x7; }
+    constexpr uint8_t move_promotion(Move m) { return (m >> 12) & 0x3; }
     constexpr uint8_t move_flags(Move m) { return (m >> 14) & 0x3; }
+    constexpr bool is_promotion(Move m) { return move_flags(m) == MOVE_PROMOTION; }
+
+    constexpr int MAX_LEGAL_MOVES = 256;
+
+    // Fixed-capacity move buffer for move generation. It lives on the stack,
+    // so generating moves never touches the heap.
+    struct MoveList
+    {
+        Move moves[MAX_LEGAL_MOVES];
+        int32_t scores[MAX_LEGAL_MOVES]; // optional, filled by move ordering
+        uint32_t count = 0;
+
+        void push_back(Move m) { moves[count++] = m; }
+        void clear() { count = 0; }
+
+        uint32_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        Move &operator[](uint32_t i) { return moves[i]; }
+        Move operator[](uint32_t i) const { return moves[i]; }
+
+        Move *begin() { return moves; }
+        Move *end() { return moves + count; }
+        const Move *begin() const { return moves; }
+        const Move *end() const { return moves + count; }
+    };
 
     int square_from_str(const std::string &sq);
     std::string square_to_str(int sq);
@@ -0,0 +1,74 @@
+#ifndef CHESS_CORE_PERFT_HPP
+#define CHESS_CORE_PERFT_HPP
+
+#include "board.hpp"
+#include "move.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace chess
+{
+
+    // Subtree sizes keyed by Zobrist hash and remaining depth. Transpositions
+    // are common in perft trees, so even a small cache cuts the work a lot.
+    //
+    // Lock-free: an entry stores key ^ data next to data, so a torn write from
+    // another thread fails verification instead of returning a wrong count.
+    struct PerftEntry
+    {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;  // nodes << 8 | depth, 0 when empty
+    };
+
+    struct PerftCache
+    {
+        std::unique_ptr<PerftEntry[]> entries;
+        uint64_t mask = 0;
+        std::atomic<uint64_t> hits{0};
+
+        void resize(size_t megabytes); // rounded down to a power of two, 0 disables
+        void clear();
+        bool enabled() const { return entries != nullptr; }
+        bool probe(uint64_t key, int depth, uint64_t &nodes);
+        void store(uint64_t key, int depth, uint64_t nodes);
+    };
+
+    struct PerftOptions
+    {
+        bool bulk = true;             // count the last ply from the move list size
+        PerftCache *cache = nullptr;  // optional subtree cache, may be shared by threads
+    };
+
+    struct PerftDivide
+    {
+        Move move;
+        uint64_t nodes;
+    };
+
+    struct PerftThreadStats
+    {
+        uint64_t nodes = 0;  // leaves counted by this worker
+        uint64_t tasks = 0;  // subtrees it searched
+        uint64_t stolen = 0; // of those, taken from another worker's queue
+    };
+
+    // Leaf count of the legal move tree `depth` plies deep
+    uint64_t perft(BoardState &board, int depth, const PerftOptions &options = PerftOptions());
+
+    // Same, split by root move
+    std::vector<PerftDivide> perft_divide(BoardState &board, int depth, const PerftOptions &options = PerftOptions());
+
+    // Multi-threaded perft. The tree is split a few plies down until there are
+    // enough subtrees to keep every worker busy; workers take subtrees from
+    // their own queue and steal from the others when it runs dry. The total
+    // does not depend on the thread count or scheduling.
+    uint64_t perft_parallel(const BoardState &board, int depth, int threads,
+                            const PerftOptions &options = PerftOptions(),
+                            std::vector<PerftThreadStats> *stats = nullptr);
+
+} // namespace chess
+
+#endif
@@ -23,6 +23,8 @@ namespace chess
         BLACK = 1
     };
 
+    constexpr uint8_t NO_PIECE = NONE; // make_piece(NONE, WHITE)
+
     constexpr Color opposite_color(Color c) { return static_cast<Color>(c ^ 1); }
     constexpr uint8_t make_piece(PieceType type, Color color) { return (color << 3) | type; }
     constexpr PieceType piece_type(uint8_t piece) { return static_cast<PieceType>(piece & 7); }
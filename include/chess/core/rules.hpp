@@ -8,6 +8,27 @@
 namespace chess
 {
 
+    // Move subsets for staged generation. GEN_CAPTURES and GEN_QUIETS are
+    // disjoint and together give GEN_ALL.
+    enum GenType : uint8_t
+    {
+        GEN_CAPTURES, // captures, en passant and all promotions
+        GEN_QUIETS,   // everything else, castling included
+        GEN_EVASIONS, // all moves; only valid when in check
+        GEN_ALL
+    };
+
+    // Legal moves of one subset
+    void generate_moves(const BoardState &board, GenType type, MoveList &moves);
+
+    void generate_legal_moves(const BoardState &board, MoveList &moves);
+    void generate_pseudo_legal_moves(const BoardState &board, MoveList &moves);
+    void generate_captures(const BoardState &board, MoveList &moves); // legal, as GEN_CAPTURES
+
+    // Without building a move list; has_any_legal_move stops at the first one
+    bool has_any_legal_move(const BoardState &board);
+    int count_legal_moves(const BoardState &board);
+
     void generate_legal_moves(const BoardState &board, std::vector<Move> &moves);
     void generate_pseudo_legal_moves(const BoardState &board, std::vector<Move> &moves);
     void generate_captures(const BoardState &board, std::vector<Move> &moves);
@@ -15,6 +36,23 @@ namespace chess
     bool is_legal_move(const BoardState &board, Move move);
     bool is_pseudo_legal(const BoardState &board, Move move);
 
+    // What gives_check needs to know about a position, computed once and
+    // reused for all of its moves
+    struct CheckInfo
+    {
+        uint8_t king;                         // the opponent's king
+        std::array<Bitboard, 6> check_squares; // squares where each piece type attacks that king
+        Bitboard discoverers;                 // own pieces alone between that king and an own slider
+    };
+
+    CheckInfo compute_check_info(const BoardState &board);
+
+    // Whether a legal move checks the opponent, without playing it
+    bool gives_check(const BoardState &board, Move move, const CheckInfo &info);
+    bool gives_check(const BoardState &board, Move move);
+    // Check plus no legal reply
+    bool gives_mate(const BoardState &board, Move move);
+
     enum GameResult
     {
         IN_PROGRESS,
@@ -27,9 +65,19 @@ namespace chess
     };
 
     GameResult check_game_result(const BoardState &board);
+    // Same, plus threefold repetition; `history` holds the moves that led to board
+    GameResult check_game_result(const BoardState &board, const MoveStack &history);
     bool is_checkmate(const BoardState &board);
     bool is_stalemate(const BoardState &board);
     bool is_draw_by_insufficient_material(const BoardState &board);
+    bool is_draw_by_fifty_moves(const BoardState &board); // caller rules out mate first
+
+    // Repetitions are found through the undo history: UndoInfo::hash is the
+    // key before each move, so the stack doubles as a key history. Only the
+    // last halfmove_clock plies are scanned, as nothing before an
+    // irreversible move can recur, and only every second one of them.
+    bool is_repetition(const BoardState &board, const MoveStack &history);     // one earlier occurrence, for search
+    int count_repetitions(const BoardState &board, const MoveStack &history);  // all earlier occurrences
 
 } // namespace chess
 
@@ -8,6 +8,7 @@ namespace chess {
 
 constexpr int32_t EVAL_INFINITY = 100000;
 constexpr int32_t EVAL_CHECKMATE = 50000;
+constexpr int32_t EVAL_NONE = EVAL_INFINITY + 1;  // no static evaluation available
 
 constexpr int32_t PIECE_VALUES[6] = {
     100,   // Pawn
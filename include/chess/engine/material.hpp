@@ -0,0 +1,53 @@
+#ifndef CHESS_ENGINE_MATERIAL_HPP
+#define CHESS_ENGINE_MATERIAL_HPP
+
+#include "../core/board.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace chess {
+
+// Score for the strong side of a recognised endgame, from its point of view
+using EndgameEvaluator = int32_t (*)(const BoardState& board, Color strong);
+
+constexpr int32_t KNOWN_WIN = 10000;
+constexpr int SCALE_NORMAL = 64;
+
+// Everything that depends only on which pieces are on the board
+struct MaterialEntry {
+    uint64_t key;                // BoardState::material_key
+    int16_t imbalance_mg;        // White minus Black
+    int16_t imbalance_eg;
+    uint8_t phase;               // 0..24, already capped
+    uint8_t scale[2];            // endgame score factor /64 when that color is ahead
+    Color strong_side;
+    EndgameEvaluator evaluator;  // replaces the generic eval when set
+};
+
+// Per-thread cache of MaterialEntry keyed by the material signature. The
+// signature changes only on captures and promotions.
+struct MaterialTable {
+    static constexpr size_t DEFAULT_ENTRIES = 1 << 13;
+
+    std::vector<MaterialEntry> entries;
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    explicit MaterialTable(size_t size = DEFAULT_ENTRIES);  // size must be a power of two
+    void clear();
+    const MaterialEntry& probe(const BoardState& board);   // fills the entry on a miss
+};
+
+MaterialTable& thread_material_table();
+
+// Uncached analysis of a material signature
+MaterialEntry analyse_material(uint64_t material_key);
+
+// Specialised endgames
+int32_t evaluate_kxk(const BoardState& board, Color strong);   // KQK, KRK, ... vs a bare king
+int32_t evaluate_kbnk(const BoardState& board, Color strong);
+int32_t evaluate_kpk(const BoardState& board, Color strong);
+
+} // namespace chess
+
+#endif
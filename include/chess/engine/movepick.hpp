@@ -0,0 +1,68 @@
+#ifndef CHESS_ENGINE_MOVEPICK_HPP
+#define CHESS_ENGINE_MOVEPICK_HPP
+
+#include "../core/board.hpp"
+#include "../core/move.hpp"
+#include <array>
+#include <cstdint>
+
+namespace chess {
+
+// Quiet move scores by from/to square, raised on beta cutoffs
+using HistoryTable = std::array<std::array<int32_t, 64>, 64>;
+
+// Captures that do not lose material first (MVV-LVA among them), then
+// queen promotions, quiet moves, and losing captures last by SEE
+int32_t move_score(const BoardState& board, Move move);
+
+// Not a capture, en passant or promotion
+bool is_quiet(const BoardState& board, Move move);
+
+// Hands out the legal moves of a position one at a time, best first, and
+// generates each group only when the ones before it are used up, so a
+// cutoff by the hash move or a capture never pays for the quiet moves:
+//   hash move, good captures, killers, countermove, quiets by history,
+//   losing captures.
+// The quiescence form stops after the good captures.
+struct MovePicker {
+    enum Stage : uint8_t {
+        STAGE_TT,
+        STAGE_CAPTURES_INIT,
+        STAGE_GOOD_CAPTURES,
+        STAGE_REFUTATIONS,
+        STAGE_QUIETS_INIT,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_DONE
+    };
+
+    const BoardState& board;
+    const HistoryTable& history;
+    Move tt_move;
+    std::array<Move, 3> refutations;  // two killers and the countermove
+    bool captures_only;
+
+    Stage stage = STAGE_TT;
+    uint32_t cur = 0;
+    uint32_t bad_end = 0;  // losing captures are moved to captures[0 .. bad_end)
+    MoveList captures;
+    MoveList quiets;
+
+    // Main search
+    MovePicker(const BoardState& board, const HistoryTable& history, Move tt_move, const std::array<Move, 2>& killers,
+               Move counter_move);
+    // Quiescence search: promotions and captures that do not lose material
+    MovePicker(const BoardState& board, const HistoryTable& history, Move tt_move);
+
+    Move next();  // MOVE_NONE once all moves are out
+
+private:
+    bool is_valid(Move move) const;
+    bool is_refutation(Move move) const;
+    void generate_captures();
+    void generate_quiets();
+};
+
+} // namespace chess
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CHESS_ENGINE_PAWNS_HPP
+#define CHESS_ENGINE_PAWNS_HPP
+
+#include "../core/board.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace chess {
+
+// Everything pawn-structure evaluation derives from the pawns and kings
+// alone. Scores are White minus Black, not yet tapered.
+struct PawnEntry {
+    uint64_t key;           // BoardState::pawn_key
+    Bitboard passed[2];     // passed pawns per color
+    int16_t mg;
+    int16_t eg;
+};
+
+// Cache of PawnEntry keyed by the pawn key. The pawn/king structure changes
+// on a small fraction of moves, so most probes hit. One table per thread,
+// so probing needs no synchronization.
+struct PawnTable {
+    static constexpr size_t DEFAULT_ENTRIES = 1 << 14;
+
+    std::vector<PawnEntry> entries;
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    explicit PawnTable(size_t size = DEFAULT_ENTRIES);  // size must be a power of two
+    void clear();
+    const PawnEntry& probe(const BoardState& board);   // evaluates on a miss
+};
+
+// The calling thread's table
+PawnTable& thread_pawn_table();
+
+// Uncached evaluation of the pawn/king structure
+PawnEntry evaluate_pawns(const BoardState& board);
+
+} // namespace chess
+
+#endif
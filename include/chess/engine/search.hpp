@@ -3,6 +3,11 @@
 
 #include "../core/board.hpp"
 #include "../core/move.hpp"
+#include "eval.hpp"
+#include "movepick.hpp"
+#include "tt.hpp"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <chrono>
@@ -23,33 +28,69 @@ struct SearchLimits {
     uint64_t max_nodes = UINT64_MAX;
     std::chrono::milliseconds max_time = std::chrono::hours(1);
     bool infinite = false;
+    int threads = 1;  // Lazy SMP: helper threads share the transposition table
 };
 
-struct TTEntry {
-    uint64_t hash;
-    Move best_move;
-    int32_t score;
-    uint8_t depth;
-    uint8_t flags;  // exact, lower bound, upper bound
+constexpr int MAX_PLY = 128;
+
+// Scores beyond this are mates, EVAL_CHECKMATE minus the distance in plies
+constexpr int32_t MATE_BOUND = EVAL_CHECKMATE - MAX_PLY;
+
+// Limits are checked once every this many nodes
+constexpr uint64_t STOP_CHECK_INTERVAL = 1024;
+
+struct SearchContext;
+
+// State shared by the threads of one search
+struct SearchShared {
+    std::atomic<bool> stop{false};
+    std::vector<const SearchContext*> threads;  // for node totals
 };
 
-struct SearchContext {
-    std::vector<TTEntry> transposition_table;
-    std::array<std::array<int32_t, 64>, 64> history_table;
-    uint64_t nodes;
+// One per search thread. Aligned so that the node counters and tables of
+// different threads never share a cache line.
+struct alignas(64) SearchContext {
+    TranspositionTable* tt;  // owned by the caller, may be shared with other searches
+    SearchShared* shared;    // null for a search on a single thread
+    int thread_id;           // 0 is the main thread, which decides when to stop
+    HistoryTable history_table;
+    std::array<std::array<Move, 2>, MAX_PLY> killers;           // quiet cutoff moves per ply
+    std::array<std::array<Move, 64>, 64> counter_moves;          // quiet reply by the previous move's squares
+    std::atomic<uint64_t> nodes;  // written by the owner only, read by all
     std::chrono::steady_clock::time_point start_time;
     SearchLimits limits;
-    
+
+    MoveStack history;  // game moves before the root, then the current line
+    int ply;            // distance from the root
+    bool stopped;       // a limit was hit; the search unwinds without results
+
+    // Triangular PV table: pv[ply] holds the best line from ply onwards,
+    // in pv[ply][ply .. pv_length[ply])
+    std::array<std::array<Move, MAX_PLY>, MAX_PLY> pv;
+    std::array<int, MAX_PLY> pv_length;
+
+    // Previous iteration's PV, tried first while the search follows it
+    std::array<Move, MAX_PLY> prev_pv;
+    int prev_pv_length;
+    bool follow_pv;
+
     SearchContext();
     void clear();
 };
 
+// Iterative deepening from `board`; `game_history` holds the moves that led
+// to it, so repetitions of earlier game positions are scored as draws.
+// Without a table argument the search uses default_tt(); a table that was
+// never resized gets TranspositionTable::DEFAULT_MB.
 SearchResult search(const BoardState& board, const SearchLimits& limits);
+SearchResult search(const BoardState& board, const SearchLimits& limits, const MoveStack& game_history);
+SearchResult search(const BoardState& board, const SearchLimits& limits, const MoveStack& game_history,
+                    TranspositionTable& tt);
 int32_t alpha_beta(BoardState& board, SearchContext& ctx, int32_t alpha, int32_t beta, uint32_t depth);
 int32_t quiescence_search(BoardState& board, SearchContext& ctx, int32_t alpha, int32_t beta);
 
 void order_moves(const BoardState& board, std::vector<Move>& moves, Move tt_move);
-int32_t move_score(const BoardState& board, Move move);
+void order_moves(const BoardState& board, MoveList& moves, Move tt_move);  // fills moves.scores
 
 bool should_stop_search(const SearchContext& ctx);
 
@@ -0,0 +1,22 @@
+#ifndef CHESS_ENGINE_SEE_HPP
+#define CHESS_ENGINE_SEE_HPP
+
+#include "../core/board.hpp"
+#include "../core/move.hpp"
+#include <cstdint>
+
+namespace chess {
+
+// Static exchange evaluation: the material balance of the capture sequence
+// on the target square of `move`, with both sides always recapturing with
+// their least valuable attacker and free to stop when it no longer pays.
+// Sliders behind the capturing piece join in as it leaves (x-rays). Pins
+// are ignored. Values are PIECE_VALUES, from the mover's point of view.
+int32_t see(const BoardState& board, Move move);
+
+// see(board, move) >= threshold, stopping as soon as the answer is known
+bool see_ge(const BoardState& board, Move move, int32_t threshold = 0);
+
+} // namespace chess
+
+#endif
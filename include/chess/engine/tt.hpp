@@ -0,0 +1,64 @@
+#ifndef CHESS_ENGINE_TT_HPP
+#define CHESS_ENGINE_TT_HPP
+
+#include "../core/move.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace chess {
+
+enum Bound : uint8_t {
+    BOUND_NONE,   // empty slot
+    BOUND_UPPER,  // score <= stored score (fail low)
+    BOUND_LOWER,  // score >= stored score (fail high)
+    BOUND_EXACT
+};
+
+// Unpacked view of a table entry
+struct TTEntry {
+    Move move;
+    int32_t score;  // mate scores count plies from the stored position
+    int32_t eval;   // static evaluation, EVAL_NONE if not computed
+    int depth;
+    Bound bound;
+};
+
+// Three entries in 32 bytes. Each entry is 10 bytes: a 16-bit key check and a
+// 64-bit data word (move 16 | score 16 | eval 16 | depth 8 | generation 6,
+// bound 2). The check is the top 16 bits of the key XORed with a fold of the
+// data word, so a torn write from another thread fails verification.
+struct alignas(32) TTBucket {
+    static constexpr int ENTRIES = 3;
+
+    std::atomic<uint16_t> check[ENTRIES];
+    uint16_t padding;
+    std::atomic<uint64_t> data[ENTRIES];
+};
+
+static_assert(sizeof(TTBucket) == 32, "two buckets per cache line");
+
+// Shared by all search threads without locks. Empty until resize(); probe
+// and store need a sized table, search() sizes an empty one itself.
+struct TranspositionTable {
+    static constexpr size_t DEFAULT_MB = 16;
+
+    std::unique_ptr<TTBucket[]> buckets;
+    uint64_t mask = 0;
+    uint8_t generation = 0;
+
+    void resize(size_t megabytes);  // rounded down to a power of two
+    void clear();
+    void new_search();              // ages every stored entry by one search
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, Move move, int32_t score, int32_t eval, int depth, Bound bound);
+    int hashfull() const;           // per mille of sampled entries written by this search
+};
+
+// Table used by search() when the caller does not pass one
+TranspositionTable& default_tt();
+
+} // namespace chess
+
+#endif
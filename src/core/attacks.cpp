@@ -0,0 +1,210 @@
+#include "chess/core/attacks.hpp"
+#include <utility>
+
+#ifdef CHESS_HAS_PEXT
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace chess
+{
+
+    // Magic numbers found offline with a fixed-seed sparse random search.
+    // They index the minimal 2^popcount(mask) slots per square.
+    static constexpr Bitboard ROOK_MAGIC_NUMBERS[64] = {
+        0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+        0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+        0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+        0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+        0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+        0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+        0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+        0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+        0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+        0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+        0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+        0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+        0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+        0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+        0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+        0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+    };
+
+    static constexpr Bitboard BISHOP_MAGIC_NUMBERS[64] = {
+        0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+        0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+        0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+        0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+        0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+        0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+        0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+        0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+        0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+        0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+        0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+        0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+        0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+        0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+        0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+        0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL,
+    };
+
+    static constexpr int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static constexpr int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    // Ray walk used only to fill the tables
+    static constexpr Bitboard sliding_attacks(uint8_t square, Bitboard occupied, const int (&directions)[4][2])
+    {
+        Bitboard attacks = 0;
+        int rank = square / 8;
+        int file = square % 8;
+
+        for (const auto &dir : directions)
+        {
+            for (int r = rank + dir[0], f = file + dir[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += dir[0], f += dir[1])
+            {
+                Bitboard sq_bb = 1ULL << (r * 8 + f);
+                attacks |= sq_bb;
+                if (occupied & sq_bb)
+                    break;
+            }
+        }
+
+        return attacks;
+    }
+
+    static constexpr unsigned popcount(Bitboard bb)
+    {
+        unsigned count = 0;
+        for (; bb; bb &= bb - 1)
+            ++count;
+        return count;
+    }
+
+    // Edge squares never affect the ray, so they are left out of the mask
+    static constexpr Bitboard slider_mask(uint8_t square, const int (&directions)[4][2])
+    {
+        int rank = square / 8;
+        int file = square % 8;
+        Bitboard edges = ((0xFFULL | 0xFF00000000000000ULL) & ~(0xFFULL << (rank * 8))) |
+                         ((0x0101010101010101ULL | 0x8080808080808080ULL) & ~(0x0101010101010101ULL << file));
+        return sliding_attacks(square, 0, directions) & ~edges;
+    }
+
+    // Writes the 2^popcount(mask) attack sets of one square in the order the
+    // backend indexes them. Used by the compiler for the engine's tables and
+    // at run time for fill_slider_tables.
+    template <SliderBackend Backend>
+    static constexpr void fill_square(Bitboard *table, uint8_t square, const int (&directions)[4][2], Bitboard magic)
+    {
+        const Bitboard mask = slider_mask(square, directions);
+        const unsigned shift = 64 - popcount(mask);
+
+        // Carry-Rippler enumeration of all subsets of the mask; the subsets
+        // come out in PEXT index order
+        Bitboard subset = 0;
+        unsigned n = 0;
+        do
+        {
+            unsigned index = Backend == SliderBackend::PEXT ? n++
+                                                            : static_cast<unsigned>((subset * magic) >> shift);
+            table[index] = sliding_attacks(square, subset, directions);
+            subset = (subset - mask) & mask;
+        } while (subset);
+    }
+
+    template <bool Rook, uint8_t Square>
+    static constexpr auto make_slider_table()
+    {
+        constexpr const auto &directions = Rook ? ROOK_DIRECTIONS : BISHOP_DIRECTIONS;
+        std::array<Bitboard, size_t(1) << popcount(slider_mask(Square, directions))> table{};
+        fill_square<SLIDER_BACKEND>(table.data(), Square, directions,
+                                    Rook ? ROOK_MAGIC_NUMBERS[Square] : BISHOP_MAGIC_NUMBERS[Square]);
+        return table;
+    }
+
+    // One table per square, built by the compiler like the leaper tables,
+    // so the lookups work before main() and need no initialization call
+    template <bool Rook, uint8_t Square>
+    static constexpr auto SLIDER_TABLE = make_slider_table<Rook, Square>();
+
+    template <bool Rook, size_t... Squares>
+    static constexpr std::array<Magic, 64> make_magics(std::index_sequence<Squares...>)
+    {
+        constexpr const auto &directions = Rook ? ROOK_DIRECTIONS : BISHOP_DIRECTIONS;
+        constexpr const auto &numbers = Rook ? ROOK_MAGIC_NUMBERS : BISHOP_MAGIC_NUMBERS;
+        return {{Magic{slider_mask(Squares, directions), numbers[Squares], SLIDER_TABLE<Rook, Squares>.data(),
+                       64 - popcount(slider_mask(Squares, directions))}...}};
+    }
+
+    constexpr std::array<Magic, 64> ROOK_MAGICS = make_magics<true>(std::make_index_sequence<64>{});
+    constexpr std::array<Magic, 64> BISHOP_MAGICS = make_magics<false>(std::make_index_sequence<64>{});
+
+    static void init_magics(SliderBackend backend, Magic (&magics)[64], const Bitboard (&numbers)[64],
+                            const int (&directions)[4][2], Bitboard *table)
+    {
+        for (uint8_t sq = 0; sq < 64; ++sq)
+        {
+            Magic &m = magics[sq];
+            m.mask = slider_mask(sq, directions);
+            m.magic = numbers[sq];
+            m.shift = 64 - popcount(m.mask);
+            m.attacks = table;
+
+            if (backend == SliderBackend::PEXT)
+                fill_square<SliderBackend::PEXT>(table, sq, directions, m.magic);
+            else
+                fill_square<SliderBackend::MAGIC>(table, sq, directions, m.magic);
+
+            table += 1ULL << (64 - m.shift);
+        }
+    }
+
+#ifdef CHESS_HAS_PEXT
+    static void cpuid(unsigned leaf, unsigned subleaf, unsigned (&regs)[4])
+    {
+#ifdef _MSC_VER
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<unsigned>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    static bool cpu_has_bmi2()
+    {
+        unsigned regs[4];
+        cpuid(0, 0, regs);
+        if (regs[0] < 7)
+            return false;
+        cpuid(7, 0, regs);
+        return regs[1] & (1u << 8);
+    }
+#endif
+
+    bool slider_backend_supported(SliderBackend backend)
+    {
+#ifdef CHESS_HAS_PEXT
+        return backend == SliderBackend::MAGIC || cpu_has_bmi2();
+#else
+        return backend == SliderBackend::MAGIC;
+#endif
+    }
+
+    void fill_slider_tables(SliderBackend backend, Magic (&rook)[64], Magic (&bishop)[64], Bitboard *storage)
+    {
+        init_magics(backend, rook, ROOK_MAGIC_NUMBERS, ROOK_DIRECTIONS, storage);
+        init_magics(backend, bishop, BISHOP_MAGIC_NUMBERS, BISHOP_DIRECTIONS, storage + 102400);
+    }
+
+    const char *slider_backend_name(SliderBackend backend)
+    {
+        return backend == SliderBackend::PEXT ? "BMI2 PEXT" : "magic bitboards";
+    }
+
+} // namespace chess
@@ -1,20 +1,106 @@
 #include "chess/core/board.hpp"
+#include <cassert>
 #include <cstring>
+#include <memory>
+#include <unordered_map>
 
 namespace chess
 {
 
-    // Zobrist hashing constants (placeholder)
-    const std::array<std::array<uint64_t, 64>, 12> ZOBRIST_PIECES = {};
-    const std::array<uint64_t, 16> ZOBRIST_CASTLING = {};
-    const std::array<uint64_t, 8> ZOBRIST_EN_PASSANT = {};
-    const uint64_t ZOBRIST_SIDE = 0;
+    // Zobrist keys come from a fixed-seed splitmix64 stream evaluated at
+    // compile time, so hashes are identical across runs and builds.
+    namespace
+    {
+        struct ZobristKeys
+        {
+            std::array<std::array<uint64_t, 64>, 12> pieces{};
+            std::array<uint64_t, 16> castling{};
+            std::array<uint64_t, 8> en_passant{};
+            uint64_t side = 0;
+        };
+
+        constexpr uint64_t splitmix64(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        constexpr ZobristKeys make_zobrist_keys()
+        {
+            ZobristKeys keys;
+            uint64_t state = 0x1BADB002DEADBEEFULL;
+
+            for (auto &piece : keys.pieces)
+                for (auto &key : piece)
+                    key = splitmix64(state);
+
+            // One key per right; the 16 entries are the XOR of the rights in the
+            // mask, so a rights change is a single XOR of old and new entries.
+            uint64_t rights[4] = {};
+            for (auto &key : rights)
+                key = splitmix64(state);
+            for (int mask = 0; mask < 16; ++mask)
+                for (int i = 0; i < 4; ++i)
+                    if (mask & (1 << i))
+                        keys.castling[mask] ^= rights[i];
+
+            for (auto &key : keys.en_passant)
+                key = splitmix64(state);
+
+            keys.side = splitmix64(state);
+            return keys;
+        }
+
+        constexpr ZobristKeys ZOBRIST = make_zobrist_keys();
+
+        // Same keys as the full hash, so the pawn key needs no stream of its own
+        constexpr std::array<std::array<uint64_t, 64>, 16> make_pawn_king_keys()
+        {
+            std::array<std::array<uint64_t, 64>, 16> keys{};
+            for (Color color : {WHITE, BLACK})
+                for (PieceType type : {PAWN, KING})
+                    keys[make_piece(type, color)] = ZOBRIST.pieces[type + 6 * color];
+            return keys;
+        }
+
+        // Castling rights that survive a move from or to each square: moving
+        // the king or a rook, or capturing a rook, clears the matching rights.
+        constexpr std::array<uint8_t, 64> make_castling_masks()
+        {
+            std::array<uint8_t, 64> masks{};
+            for (auto &m : masks)
+                m = 0xF;
+            masks[0] = static_cast<uint8_t>(~CASTLE_WHITE_QUEEN & 0xF);
+            masks[7] = static_cast<uint8_t>(~CASTLE_WHITE_KING & 0xF);
+            masks[4] = static_cast<uint8_t>(~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN) & 0xF);
+            masks[56] = static_cast<uint8_t>(~CASTLE_BLACK_QUEEN & 0xF);
+            masks[63] = static_cast<uint8_t>(~CASTLE_BLACK_KING & 0xF);
+            masks[60] = static_cast<uint8_t>(~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN) & 0xF);
+            return masks;
+        }
+
+        constexpr std::array<uint8_t, 64> CASTLING_MASK = make_castling_masks();
+    }
+
+    const std::array<std::array<uint64_t, 64>, 12> ZOBRIST_PIECES = ZOBRIST.pieces;
+    const std::array<uint64_t, 16> ZOBRIST_CASTLING = ZOBRIST.castling;
+    const std::array<uint64_t, 8> ZOBRIST_EN_PASSANT = ZOBRIST.en_passant;
+    const uint64_t ZOBRIST_SIDE = ZOBRIST.side;
+    const std::array<std::array<uint64_t, 64>, 16> ZOBRIST_PAWN_KING = make_pawn_king_keys();
+
+    // Histories of the two-argument make_move/unmake_move, see board_history
+    static thread_local std::unordered_map<const BoardState *, std::unique_ptr<MoveStack>> board_histories;
 
     BoardState::BoardState()
     {
+        if (!board_histories.empty())
+            board_histories.erase(this);
         pieces_bb.fill(0);
         colors_bb.fill(0);
         occupied = 0;
+        mailbox.fill(NO_PIECE);
 
         side_to_move = WHITE;
         castling_rights = 0;
@@ -22,8 +108,13 @@ namespace chess
         halfmove_clock = 0;
         fullmove_number = 1;
 
+        psqt_mg = 0;
+        psqt_eg = 0;
+        phase = 0;
+
         hash = 0;
-        move_stack.top = -1;
+        pawn_key = 0;
+        material_key = 0;
     }
 
     void set_starting_position(BoardState &board)
@@ -56,385 +147,194 @@ namespace chess
     void reset_board(BoardState &board)
     {
         board = BoardState();
+        board_histories.erase(&board);
     }
 
-    uint8_t piece_at(const BoardState &board, uint8_t square)
+    void place_piece(BoardState &board, uint8_t square, uint8_t piece)
     {
-        Bitboard mask = 1ULL << square;
-
-        for (uint8_t type = 0; type < 6; ++type)
-        {
-            Bitboard piece_bb = board.pieces_bb[type] & mask;
-            if (!piece_bb)
-                continue;
-
-            if (board.colors_bb[WHITE] & mask)
-                return make_piece(static_cast<PieceType>(type), WHITE);
-            if (board.colors_bb[BLACK] & mask)
-                return make_piece(static_cast<PieceType>(type), BLACK);
-        }
-
-        return make_piece(NONE, WHITE);
+        remove_piece(board, square);
+        put_piece(board, square, piece);
     }
 
-    void place_piece(BoardState &board, uint8_t square, uint8_t piece)
+    void remove_piece(BoardState &board, uint8_t square)
     {
-        Bitboard mask = 1ULL << square;
-        PieceType type = piece_type(piece);
-        Color color = piece_color(piece);
-
-        remove_piece(board, square);
+        uint8_t piece = board.mailbox[square];
+        if (piece != NO_PIECE)
+            remove_piece(board, square, piece);
+    }
 
-        board.pieces_bb[type] |= mask;
-        board.colors_bb[color] |= mask;
-        board.occupied |= mask;
+    MoveStack &board_history(const BoardState &board)
+    {
+        std::unique_ptr<MoveStack> &history = board_histories[&board];
+        if (!history)
+            history = std::make_unique<MoveStack>();
+        return *history;
     }
 
-    void remove_piece(BoardState &board, uint8_t square)
+    void make_move(BoardState &board, Move move)
     {
+        make_move(board, move, board_history(board));
+    }
 
-        Bitboard mask = 1ULL << square;
-        uint8_t piece = piece_at(board, square);
-        PieceType type = piece_type(piece);
-        Color color = piece_color(piece);
+    void unmake_move(BoardState &board, Move move)
+    {
+        auto it = board_histories.find(&board);
+        assert(it != board_histories.end() && !it->second->empty());
+        unmake_move(board, move, *it->second);
+        if (it->second->empty())
+            board_histories.erase(it);
+    }
 
-        board.pieces_bb[type] &= ~mask;
-        board.colors_bb[color] &= ~mask;
-        board.occupied &= ~mask;
+    void play_move(BoardState &board, Move move)
+    {
+        UndoInfo undo;
+        make_move(board, move, undo);
     }
 
-    void make_move(BoardState &board, Move move)
+    void make_move(BoardState &board, Move move, UndoInfo &info)
     {
         uint8_t from = move_from(move);
         uint8_t to = move_to(move);
-        uint8_t piece = piece_at(board, from);
+        uint8_t piece = board.mailbox[from];
+        uint8_t captured = board.mailbox[to];
 
         Color color = piece_color(piece);
-        PieceType type = piece_type(piece);
-        Color opp_color = (color == WHITE) ? BLACK : WHITE;
-
-        int from_file = from % 8;
-        int to_file = to % 8;
 
-        uint8_t target_piece = piece_at(board, to);
+#ifndef NDEBUG
+        uint64_t full_hash_before = compute_hash(board);
+#endif
 
-        UndoInfo info;
         info.move = move;
-        info.captured_piece = target_piece;
+        info.moved_piece = piece;
+        info.captured_piece = captured;
         info.castling_rights = board.castling_rights;
         info.en_passant_file = board.en_passant_file;
         info.halfmove_clock = board.halfmove_clock;
+        info.side_to_move = board.side_to_move;
         info.hash = board.hash;
 
-        board.move_stack.push(info);
-
-        if (target_piece != make_piece(NONE, WHITE))
-            remove_piece(board, to);
-
-        else if (type == PAWN && board.en_passant_file < 8)
+        if (board.en_passant_file < 8)
         {
-            int rank = to / 8;
-            if ((color == WHITE && rank == 5) || (color == BLACK && rank == 2))
-            {
-                if (to_file == board.en_passant_file)
-                {
-                    uint8_t captured_square = (color == WHITE) ? to - 8 : to + 8;
-                    remove_piece(board, captured_square);
-                }
-            }
+            board.hash ^= ZOBRIST_EN_PASSANT[board.en_passant_file];
+            board.en_passant_file = 8;
         }
 
-        remove_piece(board, from);
-
-        if (type == KING && abs(to_file - from_file) == 2)
+        switch (move_flags(move))
         {
-            if (to_file > from_file)
+        case MOVE_NORMAL:
+            if (captured != NO_PIECE)
+                remove_piece(board, to, captured);
+            move_piece(board, from, to, piece);
+
+            if (piece_type(piece) == PAWN && abs(int(to) - int(from)) == 16)
             {
-                uint8_t rook_from = from + 3;
-                uint8_t rook_to = from + 1;
-                uint8_t rook_piece = make_piece(ROOK, color);
-                remove_piece(board, rook_from);
-                place_piece(board, rook_to, rook_piece);
+                board.en_passant_file = from % 8;
+                board.hash ^= ZOBRIST_EN_PASSANT[board.en_passant_file];
             }
+            break;
+
+        case MOVE_PROMOTION:
+            if (captured != NO_PIECE)
+                remove_piece(board, to, captured);
+            remove_piece(board, from, piece);
+            put_piece(board, to, make_piece(static_cast<PieceType>(KNIGHT + move_promotion(move)), color));
+            break;
+
+        case MOVE_EN_PASSANT:
+            // The captured pawn sits behind the target square: to ^ 8
+            remove_piece(board, to ^ 8, make_piece(PAWN, opposite_color(color)));
+            move_piece(board, from, to, piece);
+            break;
+
+        case MOVE_CASTLING:
+            move_piece(board, from, to, piece);
+            if (to > from)
+                move_piece(board, from + 3, from + 1, make_piece(ROOK, color));
             else
-            {
-                uint8_t rook_from = from - 4;
-                uint8_t rook_to = from - 1;
-                uint8_t rook_piece = make_piece(ROOK, color);
-                remove_piece(board, rook_from);
-                place_piece(board, rook_to, rook_piece);
-            }
+                move_piece(board, from - 4, from - 1, make_piece(ROOK, color));
+            break;
         }
 
-        bool is_promotion = (type == PAWN) && ((color == WHITE && to >= 56) || (color == BLACK && to <= 7));
-        if (is_promotion)
-        {
-            uint8_t promotion_type = move_promotion(move);
-            if (promotion_type == NONE)
-                promotion_type = QUEEN;
-            uint8_t promotion_piece = make_piece(static_cast<PieceType>(promotion_type), color);
-            place_piece(board, to, promotion_piece);
-        }
-        else
+        if (board.castling_rights)
         {
-            place_piece(board, to, piece);
+            board.castling_rights &= CASTLING_MASK[from] & CASTLING_MASK[to];
+            board.hash ^= ZOBRIST_CASTLING[info.castling_rights] ^ ZOBRIST_CASTLING[board.castling_rights];
         }
 
-        if (type == PAWN && abs((int)to - (int)from) == 16)
-            board.en_passant_file = from_file;
-        else
-            board.en_passant_file = 8;
-
-        if (type == KING)
-        {
-            if (color == WHITE)
-                board.castling_rights &= ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN);
-            else
-                board.castling_rights &= ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN);
-        }
-        if (type == ROOK)
-        {
-            if (from == 0)
-                board.castling_rights &= ~CASTLE_WHITE_QUEEN;
-            if (from == 7)
-                board.castling_rights &= ~CASTLE_WHITE_KING;
-            if (from == 56)
-                board.castling_rights &= ~CASTLE_BLACK_QUEEN;
-            if (from == 63)
-                board.castling_rights &= ~CASTLE_BLACK_KING;
-        }
-        if (target_piece != make_piece(NONE, WHITE) && piece_type(target_piece) == ROOK)
-        {
-            uint8_t to_sq = to;
-            if (to_sq == 0)
-                board.castling_rights &= ~CASTLE_WHITE_QUEEN;
-            if (to_sq == 7)
-                board.castling_rights &= ~CASTLE_WHITE_KING;
-            if (to_sq == 56)
-                board.castling_rights &= ~CASTLE_BLACK_QUEEN;
-            if (to_sq == 63)
-                board.castling_rights &= ~CASTLE_BLACK_KING;
-        }
-
-        board.side_to_move = opp_color;
-        board.hash = compute_hash(board);
+        // Pawn moves and captures are irreversible and reset the clock. It
+        // saturates rather than wrapping, so the fifty-move test stays valid.
+        if (piece_type(piece) == PAWN || captured != NO_PIECE)
+            board.halfmove_clock = 0;
+        else if (board.halfmove_clock < 255)
+            board.halfmove_clock++;
+        if (color == BLACK)
+            board.fullmove_number++;
+
+        // The side follows the moved piece, so a move played for the side
+        // not to move (hand-built positions in tests) leaves it unchanged
+        board.side_to_move = opposite_color(color);
+        if (board.side_to_move != info.side_to_move)
+            board.hash ^= ZOBRIST_SIDE;
+
+        // The incremental update must change the hash exactly as a full
+        // recomputation would. Comparing deltas keeps the check valid for
+        // positions whose fields were set up by hand.
+        assert((board.hash ^ info.hash) == (compute_hash(board) ^ full_hash_before));
+        // Only pieces feed the pawn and material keys, so they must match exactly
+        assert(board.pawn_key == compute_pawn_key(board));
+        assert(board.material_key == compute_material_key(board));
     }
 
-    void unmake_move(BoardState &board, Move move)
+    void unmake_move(BoardState &board, Move move, const UndoInfo &info)
     {
-        UndoInfo info = board.move_stack.pop();
-
         uint8_t from = move_from(move);
         uint8_t to = move_to(move);
+        uint8_t piece = info.moved_piece;
 
-        board.side_to_move = opposite_color(board.side_to_move);
-        Color color = board.side_to_move;
-
-        uint8_t piece = piece_at(board, to);
-        PieceType type = piece_type(piece);
-
-        bool was_promotion =
-            type != PAWN &&
-            ((color == WHITE && to >= 56) || (color == BLACK && to <= 7));
-
-        remove_piece(board, to);
-
-        if (was_promotion)
-            place_piece(board, from, make_piece(PAWN, color));
-        else
-            place_piece(board, from, piece);
+        Color color = piece_color(piece);
+        board.side_to_move = Color(info.side_to_move);
 
-        if (type == KING && abs((to % 8) - (from % 8)) == 2)
+        switch (move_flags(move))
         {
+        case MOVE_NORMAL:
+            move_piece(board, to, from, piece);
+            if (info.captured_piece != NO_PIECE)
+                put_piece(board, to, info.captured_piece);
+            break;
+
+        case MOVE_PROMOTION:
+            remove_piece(board, to, board.mailbox[to]);
+            put_piece(board, from, piece);
+            if (info.captured_piece != NO_PIECE)
+                put_piece(board, to, info.captured_piece);
+            break;
+
+        case MOVE_EN_PASSANT:
+            move_piece(board, to, from, piece);
+            put_piece(board, to ^ 8, make_piece(PAWN, opposite_color(color)));
+            break;
+
+        case MOVE_CASTLING:
+            move_piece(board, to, from, piece);
             if (to > from)
-            {
-                uint8_t rook_from = from + 1;
-                uint8_t rook_to = from + 3;
-                remove_piece(board, rook_from);
-                place_piece(board, rook_to, make_piece(ROOK, color));
-            }
+                move_piece(board, from + 1, from + 3, make_piece(ROOK, color));
             else
-            {
-                uint8_t rook_from = from - 1;
-                uint8_t rook_to = from - 4;
-                remove_piece(board, rook_from);
-                place_piece(board, rook_to, make_piece(ROOK, color));
-            }
-        }
-
-        bool was_en_passant =
-            type == PAWN &&
-            (from % 8 != to % 8) &&
-            info.captured_piece == make_piece(NONE, WHITE) &&
-            info.en_passant_file == (to % 8);
-
-        if (was_en_passant)
-        {
-            if (was_en_passant)
-            {
-                uint8_t cap_sq = (color == WHITE) ? to - 8 : to + 8;
-                place_piece(board, cap_sq, make_piece(PAWN, opposite_color(color)));
-            }
-        }
-        else if (info.captured_piece != make_piece(NONE, WHITE))
-        {
-            place_piece(board, to, info.captured_piece);
+                move_piece(board, from - 1, from - 4, make_piece(ROOK, color));
+            break;
         }
 
         board.castling_rights = info.castling_rights;
         board.en_passant_file = info.en_passant_file;
         board.halfmove_clock = info.halfmove_clock;
+        if (color == BLACK)
+            board.fullmove_number--;
         board.hash = info.hash;
     }
 
-    Bitboard get_pawn_attacks(uint8_t square, Color color)
-    {
-        Bitboard bb = 1ULL << square;
-
-        if (color == WHITE)
-        {
-            return ((bb & 0xFEFEFEFEFEFEFEFEULL) << 7) |
-                   ((bb & 0x7F7F7F7F7F7F7F7FULL) << 9);
-        }
-        else
-        {
-            return ((bb & 0x7F7F7F7F7F7F7F7FULL) >> 7) |
-                   ((bb & 0xFEFEFEFEFEFEFEFEULL) >> 9);
-        }
-    }
-
-    Bitboard get_knight_attacks(uint8_t square)
-    {
-
-        Bitboard bb = 1ULL << square;
-        Bitboard attacks = 0;
-
-        attacks |= (bb & 0xFEFEFEFEFEFEFEFEULL) << 15;
-        attacks |= (bb & 0xFCFCFCFCFCFCFCFCULL) << 6;
-        attacks |= (bb & 0x7F7F7F7F7F7F7F7FULL) << 17;
-        attacks |= (bb & 0x3F3F3F3F3F3F3F3FULL) << 10;
-
-        attacks |= (bb & 0x7F7F7F7F7F7F7F7FULL) >> 15;
-        attacks |= (bb & 0x3F3F3F3F3F3F3F3FULL) >> 6;
-        attacks |= (bb & 0xFEFEFEFEFEFEFEFEULL) >> 17;
-        attacks |= (bb & 0xFCFCFCFCFCFCFCFCULL) >> 10;
-
-        return attacks;
-    }
-
-    Bitboard get_king_attacks(uint8_t square)
-    {
-
-        Bitboard bb = 1ULL << square;
-        Bitboard attacks = 0;
-
-        attacks |= (bb & 0xFEFEFEFEFEFEFEFEULL) >> 1;
-        attacks |= (bb & 0x7F7F7F7F7F7F7F7FULL) << 1;
-
-        attacks |= bb << 8;
-        attacks |= bb >> 8;
-
-        attacks |= (bb & 0xFEFEFEFEFEFEFEFEULL) << 7;
-        attacks |= (bb & 0x7F7F7F7F7F7F7F7FULL) << 9;
-        attacks |= (bb & 0xFEFEFEFEFEFEFEFEULL) >> 9;
-        attacks |= (bb & 0x7F7F7F7F7F7F7F7FULL) >> 7;
-
-        return attacks;
-    }
-
-    Bitboard get_bishop_attacks(uint8_t square, Bitboard occupied)
-    {
-
-        Bitboard attacks = 0;
-        int rank = square / 8;
-        int file = square % 8;
-
-        for (int upright_rank = rank + 1, upright_file = file + 1; upright_rank < 8 && upright_file < 8; upright_rank++, upright_file++)
-        {
-            int sq = upright_rank * 8 + upright_file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int upleft_rank = rank + 1, upleft_file = file - 1; upleft_rank < 8 && upleft_file >= 0; upleft_rank++, upleft_file--)
-        {
-            int sq = upleft_rank * 8 + upleft_file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int downright_rank = rank - 1, downright_file = file + 1; downright_rank >= 0 && downright_file < 8; downright_rank--, downright_file++)
-        {
-            int sq = downright_rank * 8 + downright_file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int downleft_rank = rank - 1, downleft_file = file - 1; downleft_rank >= 0 && downleft_file >= 0; downleft_rank--, downleft_file--)
-        {
-            int sq = downleft_rank * 8 + downleft_file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        return attacks;
-    }
-
-    Bitboard get_rook_attacks(uint8_t square, Bitboard occupied)
-    {
-
-        Bitboard attacks = 0;
-        int rank = square / 8;
-        int file = square % 8;
-
-        for (int north = rank + 1; north < 8; north++)
-        {
-            int sq = north * 8 + file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int south = rank - 1; south >= 0; south--)
-        {
-            int sq = south * 8 + file;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int east = file + 1; east < 8; east++)
-        {
-            int sq = rank * 8 + east;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        for (int west = file - 1; west >= 0; west--)
-        {
-            int sq = rank * 8 + west;
-            attacks |= 1ULL << sq;
-            if (occupied & (1ULL << sq))
-                break;
-        }
-
-        return attacks;
-    }
-
-    Bitboard get_queen_attacks(uint8_t square, Bitboard occupied)
-    {
-        return get_bishop_attacks(square, occupied) | get_rook_attacks(square, occupied);
-    }
-
     bool is_square_attacked(const BoardState &board, uint8_t square, Color by_color)
     {
 
-        if (get_pawn_attacks(square, by_color) & board.pieces_bb[PAWN] & board.colors_bb[by_color])
+        if (get_pawn_attacks(square, opposite_color(by_color)) & board.pieces_bb[PAWN] & board.colors_bb[by_color])
             return true;
 
         if (get_knight_attacks(square) & board.pieces_bb[KNIGHT] & board.colors_bb[by_color])
@@ -452,6 +352,19 @@ namespace chess
         return false;
     }
 
+    Bitboard attackers_to(const BoardState &board, uint8_t square, Bitboard occupied)
+    {
+        Bitboard diagonal = board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN];
+        Bitboard straight = board.pieces_bb[ROOK] | board.pieces_bb[QUEEN];
+
+        return (get_pawn_attacks(square, BLACK) & board.pieces_bb[PAWN] & board.colors_bb[WHITE]) |
+               (get_pawn_attacks(square, WHITE) & board.pieces_bb[PAWN] & board.colors_bb[BLACK]) |
+               (get_knight_attacks(square) & board.pieces_bb[KNIGHT]) |
+               (get_bishop_attacks(square, occupied) & diagonal) |
+               (get_rook_attacks(square, occupied) & straight) |
+               (get_king_attacks(square) & board.pieces_bb[KING]);
+    }
+
     bool is_in_check(const BoardState &board)
     {
 
@@ -475,18 +388,12 @@ namespace chess
             Bitboard bb = board.pieces_bb[type];
             while (bb)
             {
-                int sq = lsb(bb);
-                Color c = (board.colors_bb[WHITE] & (1ULL << sq)) ? WHITE : BLACK;
-                h ^= ZOBRIST_PIECES[type + (c * 6)][sq];
-                bb &= bb - 1;
+                int sq = pop_lsb(bb);
+                h ^= zobrist_piece_key(board.mailbox[sq], sq);
             }
         }
 
-        for (int i = 0; i < 4; ++i)
-        {
-            if (board.castling_rights & (1 << i))
-                h ^= ZOBRIST_CASTLING[i];
-        }
+        h ^= ZOBRIST_CASTLING[board.castling_rights];
 
         if (board.en_passant_file < 8)
             h ^= ZOBRIST_EN_PASSANT[board.en_passant_file];
@@ -497,6 +404,30 @@ namespace chess
         return h;
     }
 
+    uint64_t compute_pawn_key(const BoardState &board)
+    {
+        uint64_t key = 0;
+        Bitboard bb = board.pieces_bb[PAWN] | board.pieces_bb[KING];
+        while (bb)
+        {
+            int sq = pop_lsb(bb);
+            key ^= ZOBRIST_PAWN_KING[board.mailbox[sq]][sq];
+        }
+        return key;
+    }
+
+    uint64_t compute_material_key(const BoardState &board)
+    {
+        uint64_t key = 0;
+        for (Color color : {WHITE, BLACK})
+            for (int type = PAWN; type < KING; ++type)
+            {
+                uint64_t count = pop_count(board.pieces_bb[type] & board.colors_bb[color]);
+                key += count << material_shift(PieceType(type), color);
+            }
+        return key;
+    }
+
     int pop_count(Bitboard bb)
     {
         return __builtin_popcountll(bb);
@@ -1,7 +1,6 @@
 #include "chess/core/move.hpp"
 #include "chess/core/board.hpp"
 #include "chess/core/rules.hpp"
-#include <vector>
 
 namespace chess
 {
@@ -39,10 +38,9 @@ namespace chess
 
         std::string s = to_algebraic(from) + to_algebraic(to);
 
-        uint8_t promo = move_promotion(m);
-        if (promo != 0)
+        if (is_promotion(m))
         {
-            switch (promo)
+            switch (KNIGHT + move_promotion(m))
             {
             case KNIGHT:
                 s += 'n';
@@ -86,14 +84,14 @@ namespace chess
                 promo_type = QUEEN;
         }
 
-        std::vector<Move> moves;
+        MoveList moves;
         generate_legal_moves(board, moves);
 
-        for (const Move &m : moves)
+        for (Move m : moves)
         {
             if (move_from(m) == from && move_to(m) == to)
             {
-                if (promo_type != 0 && move_promotion(m) != promo_type)
+                if (promo_type != 0 && (!is_promotion(m) || KNIGHT + move_promotion(m) != promo_type))
                     continue;
                 return m;
             }
@@ -0,0 +1,243 @@
+#include "chess/core/perft.hpp"
+#include "chess/core/rules.hpp"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace chess
+{
+
+    void PerftCache::resize(size_t megabytes)
+    {
+        entries.reset();
+        mask = 0;
+
+        size_t count = megabytes * 1024 * 1024 / sizeof(PerftEntry);
+        if (count == 0)
+            return;
+
+        size_t size = 1;
+        while (size * 2 <= count)
+            size *= 2;
+
+        entries.reset(new PerftEntry[size]);
+        mask = size - 1;
+        clear();
+    }
+
+    void PerftCache::clear()
+    {
+        for (uint64_t i = 0; entries && i <= mask; ++i)
+        {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+        hits.store(0, std::memory_order_relaxed);
+    }
+
+    bool PerftCache::probe(uint64_t key, int depth, uint64_t &nodes)
+    {
+        const PerftEntry &entry = entries[key & mask];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if (data == 0 || (check ^ data) != key || int(data & 0xFF) != depth)
+            return false;
+        nodes = data >> 8;
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void PerftCache::store(uint64_t key, int depth, uint64_t nodes)
+    {
+        // Always replace: deeper subtrees are rarer but the newest entry is the
+        // one most likely to be hit again by its siblings.
+        PerftEntry &entry = entries[key & mask];
+        uint64_t data = nodes << 8 | uint64_t(depth);
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    static uint64_t perft_recursive(BoardState &board, int depth, const PerftOptions &options)
+    {
+        if (depth == 0)
+            return 1;
+
+        MoveList moves;
+        generate_legal_moves(board, moves);
+
+        if (depth == 1 && options.bulk)
+            return moves.size();
+
+        // Bulk-counted depth 1 nodes are cheaper to regenerate than to look up
+        const bool use_cache = options.cache && options.cache->enabled() && depth >= 2;
+        uint64_t nodes = 0;
+        if (use_cache && options.cache->probe(board.hash, depth, nodes))
+            return nodes;
+
+        for (Move m : moves)
+        {
+            UndoInfo undo;
+            make_move(board, m, undo);
+            nodes += perft_recursive(board, depth - 1, options);
+            unmake_move(board, m, undo);
+        }
+
+        if (use_cache && nodes)
+            options.cache->store(board.hash, depth, nodes);
+        return nodes;
+    }
+
+    uint64_t perft(BoardState &board, int depth, const PerftOptions &options)
+    {
+        return perft_recursive(board, depth, options);
+    }
+
+    std::vector<PerftDivide> perft_divide(BoardState &board, int depth, const PerftOptions &options)
+    {
+        std::vector<PerftDivide> result;
+        if (depth < 1)
+            return result;
+
+        MoveList moves;
+        generate_legal_moves(board, moves);
+
+        for (Move m : moves)
+        {
+            UndoInfo undo;
+            make_move(board, m, undo);
+            result.push_back({m, perft_recursive(board, depth - 1, options)});
+            unmake_move(board, m, undo);
+        }
+        return result;
+    }
+
+    namespace
+    {
+        struct PerftTask
+        {
+            BoardState board;
+            int depth;
+        };
+
+        // Enough subtrees per worker that stealing can even out the uneven ones
+        constexpr size_t TASKS_PER_THREAD = 16;
+        // Below this the subtrees are too small to be worth scheduling
+        constexpr int MIN_TASK_DEPTH = 3;
+
+        // Expands the tree breadth-first, one whole ply at a time, so every task
+        // has the same remaining depth. Narrow roots simply get split deeper.
+        std::vector<PerftTask> split_tasks(const BoardState &root, int depth, size_t wanted)
+        {
+            std::vector<PerftTask> tasks{{root, depth}};
+            while (tasks.size() < wanted && depth > MIN_TASK_DEPTH)
+            {
+                std::vector<PerftTask> next;
+                for (const PerftTask &task : tasks)
+                {
+                    MoveList moves;
+                    generate_legal_moves(task.board, moves);
+                    for (Move m : moves)
+                    {
+                        next.push_back({task.board, depth - 1});
+                        play_move(next.back().board, m);
+                    }
+                }
+                tasks.swap(next);
+                depth--;
+            }
+            return tasks;
+        }
+
+        struct WorkQueue
+        {
+            std::mutex lock;
+            std::deque<size_t> tasks;
+        };
+
+        struct alignas(64) PaddedStats
+        {
+            PerftThreadStats stats;
+        };
+    } // namespace
+
+    uint64_t perft_parallel(const BoardState &board, int depth, int threads,
+                            const PerftOptions &options, std::vector<PerftThreadStats> *stats)
+    {
+        threads = std::max(threads, 1);
+
+        const std::vector<PerftTask> tasks = split_tasks(board, depth, size_t(threads) * TASKS_PER_THREAD);
+        std::vector<uint64_t> results(tasks.size(), 0);
+
+        // Round-robin start so every queue begins with a similar mix of subtrees
+        std::unique_ptr<WorkQueue[]> queues(new WorkQueue[threads]);
+        for (size_t i = 0; i < tasks.size(); ++i)
+            queues[i % threads].tasks.push_back(i);
+
+        std::unique_ptr<PaddedStats[]> local(new PaddedStats[threads]);
+
+        auto worker = [&](int id)
+        {
+            PerftThreadStats &mine = local[id].stats;
+            for (;;)
+            {
+                size_t index = 0;
+                bool found = false;
+                bool stolen = false;
+
+                // Own queue from the back, victims from the front
+                {
+                    std::lock_guard<std::mutex> guard(queues[id].lock);
+                    if (!queues[id].tasks.empty())
+                    {
+                        index = queues[id].tasks.back();
+                        queues[id].tasks.pop_back();
+                        found = true;
+                    }
+                }
+                for (int i = 1; !found && i < threads; ++i)
+                {
+                    WorkQueue &victim = queues[(id + i) % threads];
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (!victim.tasks.empty())
+                    {
+                        index = victim.tasks.front();
+                        victim.tasks.pop_front();
+                        found = stolen = true;
+                    }
+                }
+
+                // Tasks are never added after the split, so empty queues mean done
+                if (!found)
+                    return;
+
+                BoardState position = tasks[index].board;
+                results[index] = perft(position, tasks[index].depth, options);
+                mine.nodes += results[index];
+                mine.tasks++;
+                mine.stolen += stolen;
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int id = 1; id < threads; ++id)
+            pool.emplace_back(worker, id);
+        worker(0);
+        for (std::thread &t : pool)
+            t.join();
+
+        if (stats)
+        {
+            stats->clear();
+            for (int id = 0; id < threads; ++id)
+                stats->push_back(local[id].stats);
+        }
+
+        // Summed in task order, independent of which thread did what
+        uint64_t nodes = 0;
+        for (uint64_t n : results)
+            nodes += n;
+        return nodes;
+    }
+
+} // namespace chess
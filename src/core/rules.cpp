@@ -1,143 +1,501 @@
 #include "chess/core/rules.hpp"
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 namespace chess
 {
 
-    void generate_legal_moves(const BoardState &board, std::vector<Move> &moves)
+    namespace
     {
-        std::vector<Move> pseudo_moves;
+        constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+        constexpr Bitboard FILE_H_BB = 0x8080808080808080ULL;
+
+        // Shift a whole set of squares one step; D is the square delta
+        template <int D>
+        constexpr Bitboard shift(Bitboard b)
+        {
+            return D == 8     ? b << 8
+                   : D == -8  ? b >> 8
+                   : D == 7   ? (b & ~FILE_A_BB) << 7
+                   : D == 9   ? (b & ~FILE_H_BB) << 9
+                   : D == -7  ? (b & ~FILE_H_BB) >> 7
+                   : D == -9  ? (b & ~FILE_A_BB) >> 9
+                              : 0;
+        }
+
+        // Attack test against an arbitrary occupancy, so the king can be checked
+        // with itself removed (sliders see through the square it leaves).
+        bool attacked_with(const BoardState &board, uint8_t square, Color by, Bitboard occupied, Bitboard enemy)
+        {
+            return (get_pawn_attacks(square, opposite_color(by)) & board.pieces_bb[PAWN] & enemy) ||
+                   (get_knight_attacks(square) & board.pieces_bb[KNIGHT] & enemy) ||
+                   (get_king_attacks(square) & board.pieces_bb[KING] & enemy) ||
+                   (get_bishop_attacks(square, occupied) & (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & enemy) ||
+                   (get_rook_attacks(square, occupied) & (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & enemy);
+        }
 
-        generate_pseudo_legal_moves(board, pseudo_moves);
-        moves.clear();
-        for (const Move &move : pseudo_moves)
+        void add_promotions(MoveList &moves, uint8_t from, uint8_t to)
         {
-            if (is_legal_move(board, move))
+            // Queen first, so callers matching on from/to alone get the usual choice
+            moves.push_back(make_promotion(from, to, QUEEN - KNIGHT));
+            moves.push_back(make_promotion(from, to, ROOK - KNIGHT));
+            moves.push_back(make_promotion(from, to, BISHOP - KNIGHT));
+            moves.push_back(make_promotion(from, to, KNIGHT - KNIGHT));
+        }
+
+        // Pawn moves generated setwise: every target came from `to - D`
+        template <int D>
+        void add_pawn_moves(MoveList &moves, Bitboard targets)
+        {
+            while (targets)
             {
-                moves.push_back(move);
+                uint8_t to = pop_lsb(targets);
+                moves.push_back(make_move(to - D, to));
             }
         }
-    }
 
-    void generate_pseudo_legal_moves(const BoardState &board, std::vector<Move> &moves)
-    {
-        moves.clear();
-        Color side_to_move = board.side_to_move;
+        template <int D>
+        void add_pawn_promotions(MoveList &moves, Bitboard targets)
+        {
+            while (targets)
+            {
+                uint8_t to = pop_lsb(targets);
+                add_promotions(moves, to - D, to);
+            }
+        }
 
-        for (uint8_t from = 0; from < 64; from++)
+        void add_moves(MoveList &moves, uint8_t from, Bitboard targets)
         {
-            if (!(board.occupied & (1ULL << from)))
-                continue;
+            while (targets)
+                moves.push_back(make_move(from, pop_lsb(targets)));
+        }
+
+        // Legal == true:  every emitted move is legal (pins, checks and king
+        //                 safety resolved from masks computed once per position).
+        // Legal == false: pseudo-legal moves; only castling is checked for attacks.
+        template <Color Us, GenType Type, bool Legal>
+        void generate(const BoardState &board, MoveList &moves)
+        {
+            constexpr Color Them = opposite_color(Us);
+            constexpr int Up = (Us == WHITE) ? 8 : -8;
+            constexpr int UpLeft = (Us == WHITE) ? 7 : -9;
+            constexpr int UpRight = (Us == WHITE) ? 9 : -7;
+            constexpr Bitboard Rank3 = (Us == WHITE) ? 0xFF0000ULL : 0xFF0000000000ULL;
+            constexpr Bitboard Rank7 = (Us == WHITE) ? 0xFF000000000000ULL : 0xFF00ULL;
+            constexpr bool Captures = Type != GEN_QUIETS;
+            constexpr bool Quiets = Type != GEN_CAPTURES;
+
+            const Bitboard own = board.colors_bb[Us];
+            const Bitboard enemy = board.colors_bb[Them];
+            const Bitboard occupied = board.occupied;
+            const Bitboard empty = ~occupied;
+            const Bitboard king_bb = board.pieces_bb[KING] & own;
+            const uint8_t king = king_bb ? lsb(king_bb) : 0;
+
+            // Destinations allowed by the generation type (captures include promotions)
+            const Bitboard type_mask = Type == GEN_CAPTURES ? enemy : Type == GEN_QUIETS ? empty : ~own;
+
+            Bitboard checkers = 0;
+            Bitboard pinned = 0;
+            Bitboard evasion_mask = ~0ULL;
+
+            // Hand-built positions without a king have nothing to keep out of check
+            if (Legal && king_bb)
+            {
+                const Bitboard enemy_diagonal = (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & enemy;
+                const Bitboard enemy_straight = (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & enemy;
+
+                checkers = (get_pawn_attacks(king, Us) & board.pieces_bb[PAWN] & enemy) |
+                           (get_knight_attacks(king) & board.pieces_bb[KNIGHT] & enemy) |
+                           (get_bishop_attacks(king, occupied) & enemy_diagonal) |
+                           (get_rook_attacks(king, occupied) & enemy_straight);
+
+                // King moves: the destination must be safe with the king lifted off the board
+                Bitboard without_king = occupied ^ king_bb;
+                Bitboard king_targets = get_king_attacks(king) & type_mask;
+                while (king_targets)
+                {
+                    uint8_t to = pop_lsb(king_targets);
+                    if (!attacked_with(board, to, Them, without_king, enemy & ~square_bb(to)))
+                        moves.push_back(make_move(king, to));
+                }
 
-            uint8_t piece = piece_at(board, from);
-            if (piece_color(piece) != side_to_move)
-                continue;
+                // Double check: only the king can move
+                if (checkers & (checkers - 1))
+                    return;
 
-            PieceType pt = piece_type(piece);
-            Bitboard targets = 0;
+                // Single check: block the ray or capture the checker
+                if (checkers)
+                    evasion_mask = BETWEEN[king][lsb(checkers)] | checkers;
 
-            switch (pt)
+                // Own pieces standing alone between the king and an enemy slider
+                Bitboard snipers = (get_bishop_attacks(king, 0) & enemy_diagonal) |
+                                   (get_rook_attacks(king, 0) & enemy_straight);
+                while (snipers)
+                {
+                    Bitboard blockers = BETWEEN[king][pop_lsb(snipers)] & occupied;
+                    if (blockers && !(blockers & (blockers - 1)))
+                        pinned |= blockers & own;
+                }
+            }
+            else if (king_bb)
             {
-            case PAWN:
+                add_moves(moves, king, get_king_attacks(king) & type_mask);
+            }
+
+            const Bitboard target_mask = type_mask & evasion_mask;
+
+            // Pawns that are not pinned, all at once
+            const Bitboard pawns = board.pieces_bb[PAWN] & own;
+            const Bitboard free_on7 = pawns & ~pinned & Rank7;
+            const Bitboard free_not7 = pawns & ~pinned & ~Rank7;
+
+            if (Quiets)
             {
-                int dir = (side_to_move == WHITE) ? 8 : -8;
-                int start_rank = (side_to_move == WHITE) ? 1 : 6;
+                Bitboard one = shift<Up>(free_not7) & empty;
+                Bitboard two = shift<Up>(one & Rank3) & empty;
+                add_pawn_moves<Up>(moves, one & evasion_mask);
+                add_pawn_moves<Up + Up>(moves, two & evasion_mask);
+            }
+
+            if (Captures)
+            {
+                add_pawn_moves<UpLeft>(moves, shift<UpLeft>(free_not7) & enemy & evasion_mask);
+                add_pawn_moves<UpRight>(moves, shift<UpRight>(free_not7) & enemy & evasion_mask);
+                add_pawn_promotions<Up>(moves, shift<Up>(free_on7) & empty & evasion_mask);
+                add_pawn_promotions<UpLeft>(moves, shift<UpLeft>(free_on7) & enemy & evasion_mask);
+                add_pawn_promotions<UpRight>(moves, shift<UpRight>(free_on7) & enemy & evasion_mask);
+            }
 
-                uint8_t to = from + dir;
-                if (to < 64 && !(board.occupied & (1ULL << to)))
+            // Pinned pawns one by one, restricted to the pin line
+            Bitboard pinned_pawns = pawns & pinned;
+            while (pinned_pawns)
+            {
+                uint8_t from = pop_lsb(pinned_pawns);
+                Bitboard from_bb = square_bb(from);
+                Bitboard push = shift<Up>(from_bb) & empty;
+                Bitboard captures = get_pawn_attacks(from, Us) & enemy;
+                Bitboard targets = 0;
+
+                if (from_bb & Rank7)
+                    targets = Captures ? (push | captures) : 0;
+                else
+                    targets = (Quiets ? push | (shift<Up>(push & Rank3) & empty) : 0) | (Captures ? captures : 0);
+
+                targets &= LINE[king][from] & evasion_mask;
+                while (targets)
                 {
-                    targets |= 1ULL << to;
-
-                    if ((from / 8) == start_rank)
-                    {
-                        uint8_t to2 = from + 2 * dir;
-                        if (!(board.occupied & (1ULL << to2)))
-                            targets |= 1ULL << to2;
-                    }
+                    uint8_t to = pop_lsb(targets);
+                    if (from_bb & Rank7)
+                        add_promotions(moves, from, to);
+                    else
+                        moves.push_back(make_move(from, to));
                 }
+            }
 
-                targets |= get_pawn_attacks(from, side_to_move) & board.colors_bb[opposite_color(side_to_move)];
-                break;
+            // En passant changes three squares at once, so it gets a full check
+            if (Captures && board.en_passant_file < 8)
+            {
+                uint8_t to = ((Us == WHITE) ? 40 : 16) + board.en_passant_file;
+                uint8_t captured = to - Up;
+                Bitboard capturers = get_pawn_attacks(to, Them) & pawns;
+                while (capturers)
+                {
+                    uint8_t from = pop_lsb(capturers);
+                    Bitboard after = (occupied ^ square_bb(from) ^ square_bb(captured)) | square_bb(to);
+                    if (!Legal || !king_bb || !attacked_with(board, king, Them, after, enemy & ~square_bb(captured)))
+                        moves.push_back(make_en_passant(from, to));
+                }
             }
-            case KNIGHT:
-                targets = get_knight_attacks(from) & ~board.colors_bb[side_to_move];
-                break;
-            case BISHOP:
-                targets = get_bishop_attacks(from, board.occupied) & ~board.colors_bb[side_to_move];
-                break;
-            case ROOK:
-                targets = get_rook_attacks(from, board.occupied) & ~board.colors_bb[side_to_move];
-                break;
-            case QUEEN:
-                targets = get_queen_attacks(from, board.occupied) & ~board.colors_bb[side_to_move];
-                break;
-            case KING:
-                targets = get_king_attacks(from) & ~board.colors_bb[side_to_move];
-                break;
-            default:
-                break;
+
+            auto pin_mask = [&](uint8_t from)
+            {
+                return (pinned & square_bb(from)) ? LINE[king][from] : ~0ULL;
+            };
+
+            // A pinned knight can never move
+            Bitboard knights = board.pieces_bb[KNIGHT] & own & ~pinned;
+            while (knights)
+            {
+                uint8_t from = pop_lsb(knights);
+                add_moves(moves, from, get_knight_attacks(from) & target_mask);
             }
 
-            while (targets)
+            Bitboard diagonal = (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & own;
+            while (diagonal)
             {
-                uint8_t to = lsb(targets);
-                targets &= targets - 1;
-                moves.push_back(make_move(from, to));
+                uint8_t from = pop_lsb(diagonal);
+                add_moves(moves, from, get_bishop_attacks(from, occupied) & target_mask & pin_mask(from));
             }
-        }
-    }
 
-    void generate_captures(const BoardState &board, std::vector<Move> &moves)
-    {
-        moves.clear();
-        Color side = board.side_to_move;
-        Color enemy = opposite_color(side);
+            Bitboard straight = (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & own;
+            while (straight)
+            {
+                uint8_t from = pop_lsb(straight);
+                add_moves(moves, from, get_rook_attacks(from, occupied) & target_mask & pin_mask(from));
+            }
 
-        for (uint8_t from = 0; from < 64; from++)
+            // Castling: not out of, through or into check, with an empty path
+            constexpr uint8_t HomeKing = (Us == WHITE) ? 4 : 60;
+            if (Quiets && Type != GEN_EVASIONS && king_bb && king == HomeKing &&
+                (Legal ? !checkers : !attacked_with(board, king, Them, occupied, enemy)))
+            {
+                constexpr uint8_t KingSide = (Us == WHITE) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+                constexpr uint8_t QueenSide = (Us == WHITE) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+                const uint8_t rook = make_piece(ROOK, Us);
+
+                if ((board.castling_rights & KingSide) && board.mailbox[king + 3] == rook &&
+                    !(occupied & (square_bb(king + 1) | square_bb(king + 2))) &&
+                    !attacked_with(board, king + 1, Them, occupied, enemy) &&
+                    !attacked_with(board, king + 2, Them, occupied, enemy))
+                    moves.push_back(make_castling(king, king + 2));
+
+                if ((board.castling_rights & QueenSide) && board.mailbox[king - 4] == rook &&
+                    !(occupied & (square_bb(king - 1) | square_bb(king - 2) | square_bb(king - 3))) &&
+                    !attacked_with(board, king - 1, Them, occupied, enemy) &&
+                    !attacked_with(board, king - 2, Them, occupied, enemy))
+                    moves.push_back(make_castling(king, king - 2));
+            }
+        }
+
+        // Counts legal moves with the generator's masks, adding up target
+        // sets with popcounts instead of emitting moves. With FirstOnly it
+        // returns as soon as anything is found, trying king moves first: they
+        // are what is left in the positions where the answer is in doubt.
+        template <Color Us, bool FirstOnly>
+        int count_legal(const BoardState &board)
         {
-            if (!(board.occupied & (1ULL << from)))
-                continue;
+            constexpr Color Them = opposite_color(Us);
+            constexpr int Up = (Us == WHITE) ? 8 : -8;
+            constexpr int UpLeft = (Us == WHITE) ? 7 : -9;
+            constexpr int UpRight = (Us == WHITE) ? 9 : -7;
+            constexpr Bitboard Rank3 = (Us == WHITE) ? 0xFF0000ULL : 0xFF0000000000ULL;
+            constexpr Bitboard Rank7 = (Us == WHITE) ? 0xFF000000000000ULL : 0xFF00ULL;
+
+            const Bitboard own = board.colors_bb[Us];
+            const Bitboard enemy = board.colors_bb[Them];
+            const Bitboard occupied = board.occupied;
+            const Bitboard empty = ~occupied;
+            const Bitboard king_bb = board.pieces_bb[KING] & own;
+
+            // Hand-built positions without a king take the generic path
+            if (!king_bb)
+            {
+                MoveList moves;
+                generate<Us, GEN_ALL, true>(board, moves);
+                return int(moves.size());
+            }
 
-            uint8_t piece = piece_at(board, from);
+            const uint8_t king = lsb(king_bb);
+            int count = 0;
 
-            if (piece_color(piece) != side)
-                continue;
+            Bitboard without_king = occupied ^ king_bb;
+            Bitboard king_targets = get_king_attacks(king) & ~own;
+            while (king_targets)
+            {
+                uint8_t to = pop_lsb(king_targets);
+                if (!attacked_with(board, to, Them, without_king, enemy & ~square_bb(to)))
+                {
+                    count++;
+                    if (FirstOnly)
+                        return count;
+                }
+            }
 
-            PieceType pt = piece_type(piece);
-            Bitboard targets = 0;
+            const Bitboard enemy_diagonal = (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & enemy;
+            const Bitboard enemy_straight = (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & enemy;
+            const Bitboard checkers = (get_pawn_attacks(king, Us) & board.pieces_bb[PAWN] & enemy) |
+                                      (get_knight_attacks(king) & board.pieces_bb[KNIGHT] & enemy) |
+                                      (get_bishop_attacks(king, occupied) & enemy_diagonal) |
+                                      (get_rook_attacks(king, occupied) & enemy_straight);
+            if (checkers & (checkers - 1))
+                return count;
+
+            const Bitboard evasion_mask = checkers ? BETWEEN[king][lsb(checkers)] | checkers : ~0ULL;
+            const Bitboard target_mask = ~own & evasion_mask;
+
+            Bitboard pinned = 0;
+            Bitboard snipers = (get_bishop_attacks(king, 0) & enemy_diagonal) |
+                               (get_rook_attacks(king, 0) & enemy_straight);
+            while (snipers)
+            {
+                Bitboard blockers = BETWEEN[king][pop_lsb(snipers)] & occupied;
+                if (blockers && !(blockers & (blockers - 1)))
+                    pinned |= blockers & own;
+            }
 
-            switch (pt)
+            const Bitboard pawns = board.pieces_bb[PAWN] & own;
+            const Bitboard free_on7 = pawns & ~pinned & Rank7;
+            const Bitboard free_not7 = pawns & ~pinned & ~Rank7;
+            const Bitboard one = shift<Up>(free_not7) & empty;
+
+            count += pop_count(one & evasion_mask) +
+                     pop_count(shift<Up>(one & Rank3) & empty & evasion_mask) +
+                     pop_count(shift<UpLeft>(free_not7) & enemy & evasion_mask) +
+                     pop_count(shift<UpRight>(free_not7) & enemy & evasion_mask) +
+                     4 * (pop_count(shift<Up>(free_on7) & empty & evasion_mask) +
+                          pop_count(shift<UpLeft>(free_on7) & enemy & evasion_mask) +
+                          pop_count(shift<UpRight>(free_on7) & enemy & evasion_mask));
+            if (FirstOnly && count)
+                return count;
+
+            Bitboard pinned_pawns = pawns & pinned;
+            while (pinned_pawns)
             {
-            case PAWN:
-                targets = get_pawn_attacks(from, side) & board.colors_bb[enemy];
-                break;
-            case KNIGHT:
-                targets = get_knight_attacks(from) & board.colors_bb[enemy];
-                break;
-            case BISHOP:
-                targets = get_bishop_attacks(from, board.occupied) & board.colors_bb[enemy];
-                break;
-            case ROOK:
-                targets = get_rook_attacks(from, board.occupied) & board.colors_bb[enemy];
-                break;
-            case QUEEN:
-                targets = get_queen_attacks(from, board.occupied) & board.colors_bb[enemy];
-                break;
-            case KING:
-                targets = get_king_attacks(from) & board.colors_bb[enemy];
-                break;
-            default:
-                break;
+                uint8_t from = pop_lsb(pinned_pawns);
+                Bitboard push = shift<Up>(square_bb(from)) & empty;
+                Bitboard targets = push | (get_pawn_attacks(from, Us) & enemy);
+                if (!(square_bb(from) & Rank7))
+                    targets |= shift<Up>(push & Rank3) & empty;
+                targets &= LINE[king][from] & evasion_mask;
+                count += pop_count(targets) * ((square_bb(from) & Rank7) ? 4 : 1);
             }
 
-            while (targets)
+            if (board.en_passant_file < 8)
+            {
+                uint8_t to = ((Us == WHITE) ? 40 : 16) + board.en_passant_file;
+                uint8_t captured = to - Up;
+                Bitboard capturers = get_pawn_attacks(to, Them) & pawns;
+                while (capturers)
+                {
+                    Bitboard after = (occupied ^ square_bb(pop_lsb(capturers)) ^ square_bb(captured)) | square_bb(to);
+                    if (!attacked_with(board, king, Them, after, enemy & ~square_bb(captured)))
+                        count++;
+                }
+            }
+            if (FirstOnly && count)
+                return count;
+
+            Bitboard knights = board.pieces_bb[KNIGHT] & own & ~pinned;
+            while (knights)
             {
-                uint8_t to = lsb(targets);
-                targets &= targets - 1;
-                moves.push_back(make_move(from, to));
+                count += pop_count(get_knight_attacks(pop_lsb(knights)) & target_mask);
+                if (FirstOnly && count)
+                    return count;
             }
+
+            Bitboard diagonal = (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & own;
+            while (diagonal)
+            {
+                uint8_t from = pop_lsb(diagonal);
+                Bitboard pin = (pinned & square_bb(from)) ? LINE[king][from] : ~0ULL;
+                count += pop_count(get_bishop_attacks(from, occupied) & target_mask & pin);
+                if (FirstOnly && count)
+                    return count;
+            }
+
+            Bitboard straight = (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & own;
+            while (straight)
+            {
+                uint8_t from = pop_lsb(straight);
+                Bitboard pin = (pinned & square_bb(from)) ? LINE[king][from] : ~0ULL;
+                count += pop_count(get_rook_attacks(from, occupied) & target_mask & pin);
+                if (FirstOnly && count)
+                    return count;
+            }
+
+            // A legal castling implies a legal king step onto the rook's
+            // square, so only a full count needs to look at it
+            constexpr uint8_t HomeKing = (Us == WHITE) ? 4 : 60;
+            if (!FirstOnly && !checkers && king == HomeKing)
+            {
+                constexpr uint8_t KingSide = (Us == WHITE) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+                constexpr uint8_t QueenSide = (Us == WHITE) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+                const uint8_t rook = make_piece(ROOK, Us);
+
+                if ((board.castling_rights & KingSide) && board.mailbox[king + 3] == rook &&
+                    !(occupied & (square_bb(king + 1) | square_bb(king + 2))) &&
+                    !attacked_with(board, king + 1, Them, occupied, enemy) &&
+                    !attacked_with(board, king + 2, Them, occupied, enemy))
+                    count++;
+
+                if ((board.castling_rights & QueenSide) && board.mailbox[king - 4] == rook &&
+                    !(occupied & (square_bb(king - 1) | square_bb(king - 2) | square_bb(king - 3))) &&
+                    !attacked_with(board, king - 1, Them, occupied, enemy) &&
+                    !attacked_with(board, king - 2, Them, occupied, enemy))
+                    count++;
+            }
+            return count;
         }
+
+        // Runtime side-to-move dispatch happens once per call
+        template <GenType Type, bool Legal>
+        void generate_for_side(const BoardState &board, MoveList &moves)
+        {
+            moves.clear();
+            if (board.side_to_move == WHITE)
+                generate<WHITE, Type, Legal>(board, moves);
+            else
+                generate<BLACK, Type, Legal>(board, moves);
+        }
+    } // namespace
+
+    void generate_moves(const BoardState &board, GenType type, MoveList &moves)
+    {
+        switch (type)
+        {
+        case GEN_CAPTURES:
+            generate_for_side<GEN_CAPTURES, true>(board, moves);
+            break;
+        case GEN_QUIETS:
+            generate_for_side<GEN_QUIETS, true>(board, moves);
+            break;
+        case GEN_EVASIONS:
+            generate_for_side<GEN_EVASIONS, true>(board, moves);
+            break;
+        case GEN_ALL:
+            generate_for_side<GEN_ALL, true>(board, moves);
+            break;
+        }
+    }
+
+    void generate_legal_moves(const BoardState &board, MoveList &moves)
+    {
+        generate_for_side<GEN_ALL, true>(board, moves);
+    }
+
+    void generate_pseudo_legal_moves(const BoardState &board, MoveList &moves)
+    {
+        generate_for_side<GEN_ALL, false>(board, moves);
+    }
+
+    void generate_captures(const BoardState &board, MoveList &moves)
+    {
+        generate_for_side<GEN_CAPTURES, true>(board, moves);
+    }
+
+    bool has_any_legal_move(const BoardState &board)
+    {
+        return board.side_to_move == WHITE ? count_legal<WHITE, true>(board) > 0
+                                           : count_legal<BLACK, true>(board) > 0;
+    }
+
+    int count_legal_moves(const BoardState &board)
+    {
+        return board.side_to_move == WHITE ? count_legal<WHITE, false>(board)
+                                           : count_legal<BLACK, false>(board);
+    }
+
+    void generate_legal_moves(const BoardState &board, std::vector<Move> &moves)
+    {
+        MoveList list;
+        generate_legal_moves(board, list);
+        moves.assign(list.begin(), list.end());
+    }
+
+    void generate_pseudo_legal_moves(const BoardState &board, std::vector<Move> &moves)
+    {
+        MoveList list;
+        generate_pseudo_legal_moves(board, list);
+        moves.assign(list.begin(), list.end());
+    }
+
+    void generate_captures(const BoardState &board, std::vector<Move> &moves)
+    {
+        MoveList list;
+        generate_captures(board, list);
+        moves.assign(list.begin(), list.end());
     }
 
     bool is_legal_move(const BoardState &board, Move move)
@@ -145,59 +503,260 @@ namespace chess
         if (!is_pseudo_legal(board, move))
             return false;
 
-        BoardState copy = board;
-
-        Color mover = board.side_to_move;
+        // Castling already had its squares checked by is_pseudo_legal
+        if (move_flags(move) == MOVE_CASTLING)
+            return true;
 
-        make_move(copy, move);
+        const Color us = board.side_to_move;
+        const Color them = opposite_color(us);
+        const Bitboard king_bb = board.pieces_bb[KING] & board.colors_bb[us];
+        if (!king_bb)
+            return true;
 
-        copy.side_to_move = mover;
+        // Replay the move on the occupancy alone and look for an attack on
+        // the king from what is left of the enemy
+        const uint8_t from = move_from(move);
+        const uint8_t to = move_to(move);
+        Bitboard occupied = (board.occupied ^ square_bb(from)) | square_bb(to);
+        Bitboard enemy = board.colors_bb[them] & ~square_bb(to);
+        if (move_flags(move) == MOVE_EN_PASSANT)
+        {
+            const uint8_t captured = (us == WHITE) ? to - 8 : to + 8;
+            occupied ^= square_bb(captured);
+            enemy &= ~square_bb(captured);
+        }
 
-        return !is_in_check(copy);
+        const uint8_t king = (king_bb & square_bb(from)) ? to : lsb(king_bb);
+        return !attacked_with(board, king, them, occupied, enemy);
     }
 
+    // Exactly the moves generate_pseudo_legal_moves would produce, without
+    // generating them. Hash and killer moves may come from another position,
+    // and make_move trusts whatever it is given.
     bool is_pseudo_legal(const BoardState &board, Move move)
     {
-        uint8_t from = move_from(move);
-        uint8_t to = move_to(move);
+        const Color us = board.side_to_move;
+        const Color them = opposite_color(us);
+        const uint8_t from = move_from(move);
+        const uint8_t to = move_to(move);
+        const uint8_t flags = move_flags(move);
+        const Bitboard own = board.colors_bb[us];
+        const Bitboard enemy = board.colors_bb[them];
+        const Bitboard occupied = board.occupied;
+        const Bitboard to_bb = square_bb(to);
+
+        const uint8_t piece = piece_at(board, from);
+        if (from == to || piece == NO_PIECE || piece_color(piece) != us || (own & to_bb))
+            return false;
 
-        if (!(board.occupied & (1ULL << from)))
+        // The promotion bits are only set on promotions
+        if (flags != MOVE_PROMOTION && move_promotion(move) != 0)
             return false;
 
-        uint8_t piece = piece_at(board, from);
-        if (piece_color(piece) != board.side_to_move)
+        const PieceType type = piece_type(piece);
+
+        if (flags == MOVE_CASTLING)
+        {
+            const uint8_t home = (us == WHITE) ? 4 : 60;
+            if (type != KING || from != home || (to != home + 2 && to != home - 2))
+                return false;
+
+            const bool king_side = to > from;
+            const uint8_t right = us == WHITE ? (king_side ? CASTLE_WHITE_KING : CASTLE_WHITE_QUEEN)
+                                              : (king_side ? CASTLE_BLACK_KING : CASTLE_BLACK_QUEEN);
+            const uint8_t rook_square = king_side ? home + 3 : home - 4;
+            if (!(board.castling_rights & right) || board.mailbox[rook_square] != make_piece(ROOK, us))
+                return false;
+            if (occupied & BETWEEN[from][rook_square])
+                return false;
+
+            // Not out of, through or into check
+            const uint8_t through = king_side ? home + 1 : home - 1;
+            return !attacked_with(board, from, them, occupied, enemy) &&
+                   !attacked_with(board, through, them, occupied, enemy) &&
+                   !attacked_with(board, to, them, occupied, enemy);
+        }
+
+        if (type == PAWN)
+        {
+            const int up = (us == WHITE) ? 8 : -8;
+            const int rank = to / 8;
+            const bool last_rank = rank == ((us == WHITE) ? 7 : 0);
+            const bool diagonal = get_pawn_attacks(from, us) & to_bb;
+
+            if (flags == MOVE_EN_PASSANT)
+                return diagonal && board.en_passant_file < 8 && to == ((us == WHITE) ? 40 : 16) + board.en_passant_file &&
+                       board.mailbox[to - up] == make_piece(PAWN, them);
+
+            // Reaching the last rank is always a promotion, and only that is
+            if ((flags == MOVE_PROMOTION) != last_rank)
+                return false;
+
+            if (diagonal)
+                return enemy & to_bb;
+            if (occupied & to_bb)
+                return false;
+            if (to == from + up)
+                return true;
+
+            const int start_rank = (us == WHITE) ? 1 : 6;
+            return to == from + 2 * up && from / 8 == start_rank && !(occupied & square_bb(from + up));
+        }
+
+        if (flags != MOVE_NORMAL)
             return false;
 
-        return true;
+        switch (type)
+        {
+        case KNIGHT:
+            return get_knight_attacks(from) & to_bb;
+        case BISHOP:
+            return get_bishop_attacks(from, occupied) & to_bb;
+        case ROOK:
+            return get_rook_attacks(from, occupied) & to_bb;
+        case QUEEN:
+            return (get_bishop_attacks(from, occupied) | get_rook_attacks(from, occupied)) & to_bb;
+        case KING:
+            return get_king_attacks(from) & to_bb;
+        default:
+            return false;
+        }
+    }
+
+    CheckInfo compute_check_info(const BoardState &board)
+    {
+        const Color us = board.side_to_move;
+        const Bitboard own = board.colors_bb[us];
+        const Bitboard their_king = board.pieces_bb[KING] & board.colors_bb[opposite_color(us)];
+
+        CheckInfo info = {};
+        if (!their_king)
+            return info;
+
+        const uint8_t king = lsb(their_king);
+        info.king = king;
+        info.check_squares[PAWN] = get_pawn_attacks(king, opposite_color(us));
+        info.check_squares[KNIGHT] = get_knight_attacks(king);
+        info.check_squares[BISHOP] = get_bishop_attacks(king, board.occupied);
+        info.check_squares[ROOK] = get_rook_attacks(king, board.occupied);
+        info.check_squares[QUEEN] = info.check_squares[BISHOP] | info.check_squares[ROOK];
+        info.check_squares[KING] = 0;
+
+        Bitboard snipers = (get_bishop_attacks(king, 0) & (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & own) |
+                           (get_rook_attacks(king, 0) & (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & own);
+        while (snipers)
+        {
+            Bitboard blockers = BETWEEN[king][pop_lsb(snipers)] & board.occupied;
+            if (blockers && !(blockers & (blockers - 1)))
+                info.discoverers |= blockers & own;
+        }
+        return info;
+    }
+
+    bool gives_check(const BoardState &board, Move move, const CheckInfo &info)
+    {
+        const uint8_t from = move_from(move);
+        const uint8_t to = move_to(move);
+        const Color us = board.side_to_move;
+        const Bitboard own = board.colors_bb[us];
+        const Bitboard king_bb = board.pieces_bb[KING] & board.colors_bb[opposite_color(us)];
+        if (!king_bb)
+            return false;
+
+        // Direct check from the destination
+        if (info.check_squares[piece_type(piece_at(board, from))] & square_bb(to))
+            return true;
+
+        // Discovered check: a blocker leaving the line to the king
+        if ((info.discoverers & square_bb(from)) && !(LINE[from][info.king] & square_bb(to)))
+            return true;
+
+        switch (move_flags(move))
+        {
+        case MOVE_NORMAL:
+            return false;
+
+        case MOVE_PROMOTION:
+            // The new piece sees through the square the pawn left
+            switch (KNIGHT + move_promotion(move))
+            {
+            case KNIGHT:
+                return get_knight_attacks(to) & king_bb;
+            case BISHOP:
+                return get_bishop_attacks(to, board.occupied ^ square_bb(from)) & king_bb;
+            case ROOK:
+                return get_rook_attacks(to, board.occupied ^ square_bb(from)) & king_bb;
+            default:
+                return get_queen_attacks(to, board.occupied ^ square_bb(from)) & king_bb;
+            }
+
+        case MOVE_EN_PASSANT:
+        {
+            // Two squares are vacated at once, so only a full slider test is safe
+            Bitboard occupied = (board.occupied ^ square_bb(from) ^ square_bb(to ^ 8)) | square_bb(to);
+            return (get_bishop_attacks(info.king, occupied) & (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]) & own) ||
+                   (get_rook_attacks(info.king, occupied) & (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]) & own);
+        }
+
+        case MOVE_CASTLING:
+        {
+            uint8_t rook_from = to > from ? from + 3 : from - 4;
+            uint8_t rook_to = to > from ? from + 1 : from - 1;
+            Bitboard occupied = (board.occupied ^ square_bb(from) ^ square_bb(rook_from)) | square_bb(to) | square_bb(rook_to);
+            return get_rook_attacks(rook_to, occupied) & king_bb;
+        }
+        }
+        return false;
+    }
+
+    bool gives_check(const BoardState &board, Move move)
+    {
+        return gives_check(board, move, compute_check_info(board));
+    }
+
+    bool gives_mate(const BoardState &board, Move move)
+    {
+        if (!gives_check(board, move))
+            return false;
+
+        BoardState after = board;
+        play_move(after, move);
+        return !has_any_legal_move(after);
     }
 
     GameResult check_game_result(const BoardState &board)
     {
-        std::vector<Move> moves;
-        generate_legal_moves(board, moves);
-        if (!moves.empty())
-            return IN_PROGRESS;
+        if (!has_any_legal_move(board))
+        {
+            if (is_in_check(board))
+                return (board.side_to_move == WHITE) ? BLACK_WINS : WHITE_WINS;
+            return DRAW_STALEMATE;
+        }
 
-        if (is_in_check(board))
-            return (board.side_to_move == WHITE) ? BLACK_WINS : WHITE_WINS;
+        if (is_draw_by_fifty_moves(board))
+            return DRAW_FIFTY_MOVE;
+        if (is_draw_by_insufficient_material(board))
+            return DRAW_INSUFFICIENT;
 
-        return DRAW_STALEMATE;
+        return IN_PROGRESS;
     }
 
-    bool is_checkmate(const BoardState &board)
+    GameResult check_game_result(const BoardState &board, const MoveStack &history)
     {
-        std::vector<Move> moves;
-        generate_legal_moves(board, moves);
+        GameResult result = check_game_result(board);
+        if (result == IN_PROGRESS && count_repetitions(board, history) >= 2)
+            return DRAW_REPETITION;
+        return result;
+    }
 
-        return moves.empty() && is_in_check(board);
+    bool is_checkmate(const BoardState &board)
+    {
+        return is_in_check(board) && !has_any_legal_move(board);
     }
 
     bool is_stalemate(const BoardState &board)
     {
-        std::vector<Move> moves;
-        generate_legal_moves(board, moves);
-
-        return moves.empty() && !is_in_check(board);
+        return !is_in_check(board) && !has_any_legal_move(board);
     }
 
     bool is_draw_by_insufficient_material(const BoardState &board)
@@ -252,4 +811,36 @@ namespace chess
         return true;
     }
 
+    bool is_draw_by_fifty_moves(const BoardState &board)
+    {
+        return board.halfmove_clock >= 100;
+    }
+
+    namespace
+    {
+        // Earlier occurrences of the current position, stopping at `limit`.
+        // A position needs at least four plies to come back.
+        int repetitions(const BoardState &board, const MoveStack &history, int limit)
+        {
+            int reversible = std::min(int(board.halfmove_clock), history.top + 1);
+            int count = 0;
+            for (int ply = 4; ply <= reversible; ply += 2)
+            {
+                if (history.stack[history.top + 1 - ply].hash == board.hash && ++count == limit)
+                    break;
+            }
+            return count;
+        }
+    } // namespace
+
+    bool is_repetition(const BoardState &board, const MoveStack &history)
+    {
+        return repetitions(board, history, 1) > 0;
+    }
+
+    int count_repetitions(const BoardState &board, const MoveStack &history)
+    {
+        return repetitions(board, history, MAX_MOVES);
+    }
+
 } // namespace chess
@@ -1,23 +1,65 @@
 #include "chess/engine/eval.hpp"
+#include "chess/engine/pawns.hpp"
+#include "chess/engine/material.hpp"
 
 namespace chess {
 
-const std::array<std::array<int32_t, 64>, 6> PST_MG = {};
-const std::array<std::array<int32_t, 64>, 6> PST_EG = {};
+// Positional part of the core tables, from White's side with a1 = 0
+static std::array<std::array<int32_t, 64>, 6> make_pst(const int16_t (&table)[6][64]) {
+    std::array<std::array<int32_t, 64>, 6> pst{};
+    for (int type = PAWN; type <= KING; ++type)
+        for (int sq = 0; sq < 64; ++sq)
+            pst[type][sq] = table[type][sq ^ 56];
+    return pst;
+}
+
+const std::array<std::array<int32_t, 64>, 6> PST_MG = make_pst(psqt::MG);
+const std::array<std::array<int32_t, 64>, 6> PST_EG = make_pst(psqt::EG);
+
+// Blend of the middlegame and endgame scores by the remaining material
+static int32_t taper(int32_t mg, int32_t eg, int phase) {
+    return (mg * phase + eg * (psqt::PHASE_MAX - phase)) / psqt::PHASE_MAX;
+}
 
+static int32_t relative(const BoardState& board, int32_t white_score) {
+    return board.side_to_move == WHITE ? white_score : -white_score;
+}
+
+// All scores are from the side to move's point of view
 int32_t evaluate(const BoardState& board) {
-    // TODO: Implement evaluation
-    return 0;
+    const MaterialEntry& material = thread_material_table().probe(board);
+
+    // Recognised endgames skip the generic terms entirely
+    if (material.evaluator) {
+        int32_t score = material.evaluator(board, material.strong_side);
+        return board.side_to_move == material.strong_side ? score : -score;
+    }
+
+    // Material and PST come straight from the sums make_move keeps, pawn
+    // structure from the pawn hash table
+    const PawnEntry& pawns = thread_pawn_table().probe(board);
+    int32_t mg = board.psqt_mg + pawns.mg + material.imbalance_mg;
+    int32_t eg = board.psqt_eg + pawns.eg + material.imbalance_eg;
+
+    // Drawish material only shrinks the endgame part of the winning side
+    eg = eg * material.scale[eg > 0 ? WHITE : BLACK] / SCALE_NORMAL;
+
+    return relative(board, taper(mg, eg, material.phase));
 }
 
 int32_t evaluate_material(const BoardState& board) {
-    // TODO: Implement material evaluation
-    return 0;
+    int32_t mg = 0, eg = 0;
+    for (int type = PAWN; type < KING; ++type) {
+        int diff = pop_count(board.pieces_bb[type] & board.colors_bb[WHITE]) -
+                   pop_count(board.pieces_bb[type] & board.colors_bb[BLACK]);
+        mg += diff * psqt::MATERIAL_MG[type];
+        eg += diff * psqt::MATERIAL_EG[type];
+    }
+    return relative(board, taper(mg, eg, get_game_phase(board)));
 }
 
 int32_t evaluate_position(const BoardState& board) {
-    // TODO: Implement positional evaluation
-    return 0;
+    return relative(board, taper(board.psqt_mg, board.psqt_eg, get_game_phase(board))) - evaluate_material(board);
 }
 
 int32_t evaluate_mobility(const BoardState& board) {
@@ -31,8 +73,13 @@ int32_t evaluate_king_safety(const BoardState& board) {
 }
 
 int32_t evaluate_pawn_structure(const BoardState& board) {
-    // TODO: Implement pawn structure evaluation
-    return 0;
+    const PawnEntry& pawns = thread_pawn_table().probe(board);
+    return relative(board, taper(pawns.mg, pawns.eg, get_game_phase(board)));
+}
+
+int get_game_phase(const BoardState& board) {
+    // Promotions can push the sum past the opening value
+    return board.phase < psqt::PHASE_MAX ? board.phase : psqt::PHASE_MAX;
 }
 
 } // namespace chess
@@ -0,0 +1,204 @@
+#include "chess/engine/material.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace chess {
+
+constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+constexpr int16_t BISHOP_PAIR_MG = 30, BISHOP_PAIR_EG = 50;
+// Knights get better and rooks worse as the own pawns stay on the board
+constexpr int16_t KNIGHT_PER_PAWN = 3;
+constexpr int16_t ROOK_PER_PAWN = -3;
+
+static int distance(int a, int b) {
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+// 0 in the centre, 60 in the corners
+static int push_to_edge(int sq) {
+    int file = sq % 8, rank = sq / 8;
+    return 10 * (std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4));
+}
+
+// 60 for adjacent kings, 0 at the far ends of the board
+static int push_close(int a, int b) {
+    return 70 - 10 * distance(a, b);
+}
+
+static int king_square(const BoardState& board, Color color) {
+    return lsb(board.pieces_bb[KING] & board.colors_bb[color]);
+}
+
+static int count(uint64_t key, PieceType type, Color color) {
+    return material_count(key, type, color);
+}
+
+// Non-pawn material in middlegame units
+static int non_pawn_material(uint64_t key, Color color) {
+    int npm = 0;
+    for (int type = KNIGHT; type < KING; ++type)
+        npm += count(key, PieceType(type), color) * psqt::MATERIAL_MG[type];
+    return npm;
+}
+
+static bool bare_king(uint64_t key, Color color) {
+    return (key >> material_shift(PAWN, color) & 0xFFFFF) == 0;
+}
+
+MaterialEntry analyse_material(uint64_t key) {
+    MaterialEntry entry = {};
+    entry.key = key;
+    entry.scale[WHITE] = entry.scale[BLACK] = SCALE_NORMAL;
+    entry.strong_side = WHITE;
+    entry.evaluator = nullptr;
+
+    int phase = 0;
+    for (Color color : {WHITE, BLACK}) {
+        for (int type = PAWN; type < KING; ++type)
+            phase += count(key, PieceType(type), color) * psqt::PHASE_WEIGHT[type];
+    }
+    entry.phase = static_cast<uint8_t>(std::min(phase, psqt::PHASE_MAX));
+
+    for (Color us : {WHITE, BLACK}) {
+        Color them = opposite_color(us);
+        int sign = us == WHITE ? 1 : -1;
+        int pawns = count(key, PAWN, us);
+
+        int mg = 0, eg = 0;
+        if (count(key, BISHOP, us) >= 2) {
+            mg += BISHOP_PAIR_MG;
+            eg += BISHOP_PAIR_EG;
+        }
+        mg += count(key, KNIGHT, us) * KNIGHT_PER_PAWN * (pawns - 5);
+        eg += count(key, KNIGHT, us) * KNIGHT_PER_PAWN * (pawns - 5);
+        mg += count(key, ROOK, us) * ROOK_PER_PAWN * (pawns - 5);
+        eg += count(key, ROOK, us) * ROOK_PER_PAWN * (pawns - 5);
+        entry.imbalance_mg += sign * mg;
+        entry.imbalance_eg += sign * eg;
+
+        // Without pawns, being a minor piece or less ahead rarely wins
+        int npm_us = non_pawn_material(key, us);
+        int npm_them = non_pawn_material(key, them);
+        if (pawns == 0 && npm_us - npm_them <= psqt::MATERIAL_MG[BISHOP]) {
+            entry.scale[us] = npm_us < psqt::MATERIAL_MG[ROOK] ? 0
+                            : npm_them <= psqt::MATERIAL_MG[BISHOP] ? 4 : 14;
+        }
+
+        // Specialised endgames against a lone king
+        if (!bare_king(key, them) || bare_king(key, us)) continue;
+
+        entry.strong_side = us;
+        bool pieces_only = pawns == 0;
+        if (pawns == 1 && npm_us == 0)
+            entry.evaluator = evaluate_kpk;
+        else if (pieces_only && count(key, BISHOP, us) == 1 && count(key, KNIGHT, us) == 1 &&
+                 npm_us == psqt::MATERIAL_MG[BISHOP] + psqt::MATERIAL_MG[KNIGHT])
+            entry.evaluator = evaluate_kbnk;
+        else if (npm_us >= psqt::MATERIAL_MG[ROOK])
+            entry.evaluator = evaluate_kxk;
+    }
+
+    return entry;
+}
+
+int32_t evaluate_kxk(const BoardState& board, Color strong) {
+    Color weak = opposite_color(strong);
+    int strong_king = king_square(board, strong);
+    int weak_king = king_square(board, weak);
+
+    int32_t result = push_to_edge(weak_king) + push_close(strong_king, weak_king);
+    for (int type = PAWN; type < KING; ++type)
+        result += count(board.material_key, PieceType(type), strong) * psqt::MATERIAL_EG[type];
+
+    Bitboard own = board.colors_bb[strong];
+    Bitboard bishops = board.pieces_bb[BISHOP] & own;
+    bool can_mate = (board.pieces_bb[QUEEN] & own) || (board.pieces_bb[ROOK] & own) ||
+                    ((bishops & DARK_SQUARES) && (bishops & ~DARK_SQUARES)) ||
+                    (bishops && (board.pieces_bb[KNIGHT] & own));
+    // Two knights and the like cannot force mate
+    return can_mate ? result + KNOWN_WIN : result / 8;
+}
+
+int32_t evaluate_kbnk(const BoardState& board, Color strong) {
+    Color weak = opposite_color(strong);
+    int strong_king = king_square(board, strong);
+    int weak_king = king_square(board, weak);
+
+    // Mate is only possible in a corner of the bishop's colour
+    bool dark = board.pieces_bb[BISHOP] & board.colors_bb[strong] & DARK_SQUARES;
+    int corner_a = dark ? 0 : 56;  // a1 or a8
+    int corner_b = dark ? 63 : 7;  // h8 or h1
+    int corner_distance = std::min(distance(weak_king, corner_a), distance(weak_king, corner_b));
+
+    return KNOWN_WIN + psqt::MATERIAL_EG[BISHOP] + psqt::MATERIAL_EG[KNIGHT] +
+           push_close(strong_king, weak_king) + (7 - corner_distance) * 20;
+}
+
+int32_t evaluate_kpk(const BoardState& board, Color strong) {
+    // Work in White's frame: the pawn always runs up the board
+    int flip = strong == WHITE ? 0 : 56;
+    int pawn = lsb(board.pieces_bb[PAWN]) ^ flip;
+    int strong_king = king_square(board, strong) ^ flip;
+    int weak_king = king_square(board, opposite_color(strong)) ^ flip;
+
+    int file = pawn % 8, rank = pawn / 8;
+    int queening = 56 + file;
+    int32_t base = psqt::MATERIAL_EG[PAWN] + rank * 10;
+
+    // Rule of the square: the defending king cannot catch the pawn
+    int pawn_moves = std::min(5, 7 - rank);
+    int weak_moves = distance(weak_king, queening) - (board.side_to_move == strong ? 0 : 1);
+    bool own_king_in_way = strong_king % 8 == file && strong_king > pawn;
+    if (pawn_moves < weak_moves && !own_king_in_way)
+        return KNOWN_WIN + base;
+
+    // A rook pawn is a draw once the defender reaches the corner
+    if ((file == 0 || file == 7) && distance(weak_king, queening) <= 1)
+        return 0;
+
+    // Attacking king on a key square wins for any other pawn
+    int key_low = rank <= 3 ? rank + 2 : rank + 1;
+    int king_rank = strong_king / 8;
+    bool on_key_square = file != 0 && file != 7 && std::abs(strong_king % 8 - file) <= 1 &&
+                         king_rank >= key_low && king_rank <= std::min(rank + 2, 7);
+    if (on_key_square)
+        return KNOWN_WIN + base;
+
+    // Defender in front of the pawn: usually a draw
+    if (weak_king % 8 == file && weak_king > pawn)
+        return base / 8;
+
+    return base + push_close(strong_king, pawn + 8) / 2 - push_close(weak_king, pawn + 8) / 2;
+}
+
+MaterialTable::MaterialTable(size_t size) : entries(size) {
+    clear();
+}
+
+void MaterialTable::clear() {
+    // Every slot holds the real entry for key 0 (bare kings), so no separate
+    // empty marker is needed
+    for (MaterialEntry& e : entries) e = analyse_material(0);
+    probes = hits = 0;
+}
+
+const MaterialEntry& MaterialTable::probe(const BoardState& board) {
+    // Neighbouring signatures differ in low bits only, so mix before indexing
+    uint64_t index = (board.material_key * 0x9E3779B97F4A7C15ULL) >> 40;
+    MaterialEntry& entry = entries[index & (entries.size() - 1)];
+    probes++;
+    if (entry.key == board.material_key) {
+        hits++;
+        return entry;
+    }
+    entry = analyse_material(board.material_key);
+    return entry;
+}
+
+MaterialTable& thread_material_table() {
+    thread_local MaterialTable table;
+    return table;
+}
+
+} // namespace chess
@@ -0,0 +1,148 @@
+#include "chess/engine/movepick.hpp"
+#include "chess/engine/eval.hpp"
+#include "chess/engine/see.hpp"
+#include "chess/core/rules.hpp"
+#include <algorithm>
+
+namespace chess {
+
+int32_t move_score(const BoardState& board, Move move) {
+    constexpr int32_t GOOD_CAPTURE = 1000000;
+    constexpr int32_t PROMOTION = 900000;
+
+    uint8_t victim = piece_at(board, move_to(move));
+    bool capture = victim != NO_PIECE || move_flags(move) == MOVE_EN_PASSANT;
+    if (capture) {
+        int32_t victim_value = victim != NO_PIECE ? PIECE_VALUES[piece_type(victim)] : PIECE_VALUES[PAWN];
+        int32_t attacker = piece_type(piece_at(board, move_from(move)));
+        if (see_ge(board, move))
+            return GOOD_CAPTURE + victim_value * 8 - attacker;
+        return -GOOD_CAPTURE + see(board, move);
+    }
+    if (is_promotion(move))
+        return PROMOTION + PIECE_VALUES[KNIGHT + move_promotion(move)];
+    return 0;
+}
+
+bool is_quiet(const BoardState& board, Move move) {
+    return piece_at(board, move_to(move)) == NO_PIECE && move_flags(move) != MOVE_EN_PASSANT &&
+           !is_promotion(move);
+}
+
+// Moves the best remaining move to position i (lazy selection sort)
+static Move pick_next(MoveList& moves, uint32_t i) {
+    uint32_t best = i;
+    for (uint32_t j = i + 1; j < moves.size(); ++j) {
+        if (moves.scores[j] > moves.scores[best]) best = j;
+    }
+    std::swap(moves.moves[i], moves.moves[best]);
+    std::swap(moves.scores[i], moves.scores[best]);
+    return moves.moves[i];
+}
+
+MovePicker::MovePicker(const BoardState& board, const HistoryTable& history, Move tt_move,
+                       const std::array<Move, 2>& killers, Move counter_move)
+    : board(board), history(history), tt_move(tt_move), refutations{killers[0], killers[1], counter_move},
+      captures_only(false) {}
+
+MovePicker::MovePicker(const BoardState& board, const HistoryTable& history, Move tt_move)
+    : board(board), history(history), tt_move(tt_move), refutations{}, captures_only(true) {
+    if (tt_move != MOVE_NONE && is_quiet(board, tt_move)) this->tt_move = MOVE_NONE;
+}
+
+void MovePicker::generate_captures() {
+    generate_moves(board, GEN_CAPTURES, captures);
+    for (uint32_t i = 0; i < captures.size(); ++i)
+        captures.scores[i] = move_score(board, captures[i]);
+}
+
+void MovePicker::generate_quiets() {
+    generate_moves(board, GEN_QUIETS, quiets);
+    for (uint32_t i = 0; i < quiets.size(); ++i)
+        quiets.scores[i] = history[move_from(quiets[i])][move_to(quiets[i])];
+}
+
+// Hash moves can come from a colliding key and killers from another
+// position, so they are checked before anything is generated
+bool MovePicker::is_valid(Move move) const {
+    return is_legal_move(board, move);
+}
+
+bool MovePicker::is_refutation(Move move) const {
+    return std::find(refutations.begin(), refutations.end(), move) != refutations.end();
+}
+
+Move MovePicker::next() {
+    switch (stage) {
+    case STAGE_TT:
+        stage = STAGE_CAPTURES_INIT;
+        if (tt_move != MOVE_NONE && is_valid(tt_move)) return tt_move;
+        tt_move = MOVE_NONE;
+        [[fallthrough]];
+
+    case STAGE_CAPTURES_INIT:
+        generate_captures();
+        cur = bad_end = 0;
+        stage = STAGE_GOOD_CAPTURES;
+        [[fallthrough]];
+
+    case STAGE_GOOD_CAPTURES:
+        while (cur < captures.size()) {
+            Move move = pick_next(captures, cur);
+            int32_t score = captures.scores[cur++];
+            if (move == tt_move) continue;
+            // Losing captures wait until after the quiets; cur never falls
+            // behind bad_end, so the slot is free
+            if (score < 0) {
+                captures.moves[bad_end++] = move;
+                continue;
+            }
+            return move;
+        }
+        cur = 0;
+        // Quiescence never searches captures that lose material
+        if (captures_only) {
+            stage = STAGE_DONE;
+            return MOVE_NONE;
+        }
+        stage = STAGE_REFUTATIONS;
+        [[fallthrough]];
+
+    case STAGE_REFUTATIONS:
+        while (cur < refutations.size()) {
+            Move move = refutations[cur++];
+            if (move == MOVE_NONE || move == tt_move) continue;
+            if (std::find(refutations.begin(), refutations.begin() + cur - 1, move) != refutations.begin() + cur - 1)
+                continue;
+            if (is_quiet(board, move) && is_valid(move)) return move;
+        }
+        stage = STAGE_QUIETS_INIT;
+        [[fallthrough]];
+
+    case STAGE_QUIETS_INIT:
+        generate_quiets();
+        cur = 0;
+        stage = STAGE_QUIETS;
+        [[fallthrough]];
+
+    case STAGE_QUIETS:
+        while (cur < quiets.size()) {
+            Move move = pick_next(quiets, cur++);
+            if (move != tt_move && !is_refutation(move)) return move;
+        }
+        cur = 0;
+        stage = STAGE_BAD_CAPTURES;
+        [[fallthrough]];
+
+    case STAGE_BAD_CAPTURES:
+        if (cur < bad_end) return captures[cur++];
+        stage = STAGE_DONE;
+        [[fallthrough]];
+
+    case STAGE_DONE:
+        break;
+    }
+    return MOVE_NONE;
+}
+
+} // namespace chess
@@ -0,0 +1,139 @@
+#include "chess/engine/pawns.hpp"
+#include <algorithm>
+
+namespace chess {
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+
+// Bonus for a passed pawn by its rank counted from its own side
+constexpr int16_t PASSED_MG[8] = {0, 5, 10, 15, 30, 50, 80, 0};
+constexpr int16_t PASSED_EG[8] = {0, 10, 15, 25, 50, 90, 140, 0};
+
+constexpr int16_t ISOLATED_MG = -8,  ISOLATED_EG = -14;
+constexpr int16_t DOUBLED_MG = -10,  DOUBLED_EG = -22;
+constexpr int16_t BACKWARD_MG = -8,  BACKWARD_EG = -10;
+
+// King shelter, middlegame only
+constexpr int16_t SHIELD_NEAR = 12;   // pawn right in front of the king
+constexpr int16_t SHIELD_FAR = 6;     // one rank further
+constexpr int16_t SHIELD_OPEN = -15;  // no own pawn ahead on a file next to the king
+
+static Bitboard file_bb(int file) { return FILE_A_BB << file; }
+
+static Bitboard adjacent_files_bb(int file) {
+    return (file > 0 ? file_bb(file - 1) : 0) | (file < 7 ? file_bb(file + 1) : 0);
+}
+
+// All ranks strictly in front of `rank` from color's point of view
+static Bitboard ranks_ahead(Color color, int rank) {
+    if (color == WHITE)
+        return rank >= 7 ? 0 : ~0ULL << (8 * (rank + 1));
+    return (1ULL << (8 * rank)) - 1;
+}
+
+static void evaluate_side(const BoardState& board, Color us, PawnEntry& entry) {
+    const Color them = opposite_color(us);
+    const Bitboard own = board.pieces_bb[PAWN] & board.colors_bb[us];
+    const Bitboard enemy = board.pieces_bb[PAWN] & board.colors_bb[them];
+    const int sign = us == WHITE ? 1 : -1;
+
+    int mg = 0, eg = 0;
+
+    Bitboard pawns = own;
+    while (pawns) {
+        int sq = pop_lsb(pawns);
+        int file = sq % 8;
+        int rank = sq / 8;
+        int relative_rank = us == WHITE ? rank : 7 - rank;
+
+        Bitboard ahead = ranks_ahead(us, rank);
+        Bitboard neighbours = adjacent_files_bb(file);
+
+        if (!(enemy & (file_bb(file) | neighbours) & ahead)) {
+            entry.passed[us] |= square_bb(sq);
+            mg += PASSED_MG[relative_rank];
+            eg += PASSED_EG[relative_rank];
+        }
+
+        // Counted once for every pawn with a friendly pawn in front of it
+        if (own & file_bb(file) & ahead) {
+            mg += DOUBLED_MG;
+            eg += DOUBLED_EG;
+        }
+
+        if (!(own & neighbours)) {
+            mg += ISOLATED_MG;
+            eg += ISOLATED_EG;
+        } else if (!(own & neighbours & ~ahead)) {
+            // No neighbour level or behind to support the advance, and the
+            // stop square is held by an enemy pawn
+            int stop = us == WHITE ? sq + 8 : sq - 8;
+            if (stop >= 0 && stop < 64 && (get_pawn_attacks(stop, us) & enemy)) {
+                mg += BACKWARD_MG;
+                eg += BACKWARD_EG;
+            }
+        }
+    }
+
+    // Shelter only matters while the king is still at home
+    Bitboard king_bb = board.pieces_bb[KING] & board.colors_bb[us];
+    if (king_bb) {
+        int king = lsb(king_bb);
+        int king_file = king % 8;
+        int king_rank = king / 8;
+        int relative_rank = us == WHITE ? king_rank : 7 - king_rank;
+
+        if (relative_rank <= 1) {
+            int forward = us == WHITE ? 8 : -8;
+            for (int f = std::max(king_file - 1, 0); f <= std::min(king_file + 1, 7); ++f) {
+                int near = king_rank * 8 + f + forward;
+                int far = near + forward;
+                if (own & square_bb(near))
+                    mg += SHIELD_NEAR;
+                else if (own & square_bb(far))
+                    mg += SHIELD_FAR;
+                else if (!(own & file_bb(f) & ranks_ahead(us, king_rank)))
+                    mg += SHIELD_OPEN;
+            }
+        }
+    }
+
+    entry.mg += sign * mg;
+    entry.eg += sign * eg;
+}
+
+PawnEntry evaluate_pawns(const BoardState& board) {
+    PawnEntry entry = {};
+    entry.key = board.pawn_key;
+    evaluate_side(board, WHITE, entry);
+    evaluate_side(board, BLACK, entry);
+    return entry;
+}
+
+PawnTable::PawnTable(size_t size) : entries(size) {
+    clear();
+}
+
+void PawnTable::clear() {
+    // A zero key never matches a position with pawns or kings on the board
+    for (PawnEntry& e : entries) e = PawnEntry{};
+    probes = hits = 0;
+}
+
+const PawnEntry& PawnTable::probe(const BoardState& board) {
+    PawnEntry& entry = entries[board.pawn_key & (entries.size() - 1)];
+    probes++;
+    if (entry.key == board.pawn_key && board.pawn_key != 0) {
+        hits++;
+        return entry;
+    }
+    entry = evaluate_pawns(board);
+    return entry;
+}
+
+PawnTable& thread_pawn_table() {
+    thread_local PawnTable table;
+    return table;
+}
+
+} // namespace chess
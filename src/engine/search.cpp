@@ -1,4 +1,9 @@
 #include "chess/engine/search.hpp"
+#include "chess/engine/eval.hpp"
+#include "chess/core/rules.hpp"
+#include <algorithm>
+#include <memory>
+#include <thread>
 
 namespace chess {
 
@@ -7,40 +12,416 @@ SearchContext::SearchContext() {
 }
 
 void SearchContext::clear() {
-    transposition_table.clear();
+    tt = nullptr;
+    shared = nullptr;
+    thread_id = 0;
     history_table = {};
+    killers = {};
+    counter_moves = {};
     nodes = 0;
     start_time = std::chrono::steady_clock::now();
+    history.top = -1;
+    ply = 0;
+    stopped = false;
+    pv_length = {};
+    prev_pv_length = 0;
+    follow_pv = false;
+}
+
+// Quiescence skips captures that cannot bring the score near alpha even
+// with this much positional gain on top of the captured piece
+constexpr int32_t DELTA_MARGIN = 200;
+
+// Bounds the history scores that order quiet moves
+constexpr int32_t HISTORY_MAX = 1 << 16;
+
+// Mate scores are stored relative to the node, so they stay valid when the
+// position is reached again at another distance from the root
+static int32_t score_to_tt(int32_t score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int32_t score_from_tt(int32_t score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Counts the node and polls the limits every STOP_CHECK_INTERVAL nodes
+static void count_node(SearchContext& ctx) {
+    // Only this thread writes the counter, so no read-modify-write is needed
+    uint64_t nodes = ctx.nodes.load(std::memory_order_relaxed) + 1;
+    ctx.nodes.store(nodes, std::memory_order_relaxed);
+    if (nodes % STOP_CHECK_INTERVAL == 0 && should_stop_search(ctx))
+        ctx.stopped = true;
+}
+
+static void update_pv(SearchContext& ctx, Move move) {
+    int ply = ctx.ply;
+    ctx.pv[ply][ply] = move;
+    for (int i = ply + 1; i < ctx.pv_length[ply + 1]; ++i)
+        ctx.pv[ply][i] = ctx.pv[ply + 1][i];
+    ctx.pv_length[ply] = std::max(ctx.pv_length[ply + 1], ply + 1);
+}
+
+static std::chrono::milliseconds elapsed(const SearchContext& ctx) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ctx.start_time);
 }
 
 SearchResult search(const BoardState& board, const SearchLimits& limits) {
-    // TODO: Implement search
+    return search(board, limits, MoveStack{});
+}
+
+SearchResult search(const BoardState& board, const SearchLimits& limits, const MoveStack& game_history) {
+    return search(board, limits, game_history, default_tt());
+}
+
+// Helper threads skip some depths so that they spread over different
+// iterations instead of all searching the main thread's (Lazy SMP)
+static bool skip_depth(int thread_id, uint32_t depth) {
+    static constexpr int SKIP_SIZE[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    static constexpr int SKIP_PHASE[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+    if (thread_id == 0) return false;
+    int i = (thread_id - 1) % 20;
+    return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2 != 0;
+}
+
+static uint64_t total_nodes(const SearchContext& ctx) {
+    if (!ctx.shared) return ctx.nodes.load(std::memory_order_relaxed);
+    uint64_t total = 0;
+    for (const SearchContext* thread : ctx.shared->threads)
+        total += thread->nodes.load(std::memory_order_relaxed);
+    return total;
+}
+
+static SearchResult iterative_deepening(BoardState root, SearchContext& ctx, Move fallback) {
+    const SearchLimits& limits = ctx.limits;
+    const bool main_thread = ctx.thread_id == 0;
+
     SearchResult result = {};
+    // Something to play even if the first iteration is cut short
+    result.best_move = fallback;
+
+    uint32_t max_depth = std::min<uint32_t>(limits.max_depth, MAX_PLY - 1);
+    for (uint32_t depth = 1; depth <= max_depth; ++depth) {
+        if (skip_depth(ctx.thread_id, depth)) continue;
+
+        ctx.follow_pv = true;
+        int32_t score = alpha_beta(root, ctx, -EVAL_INFINITY, EVAL_INFINITY, depth);
+
+        // An interrupted iteration is still usable: the root only records
+        // moves whose subtree finished, and the previous best went first
+        if (ctx.pv_length[0] > 0) {
+            result.best_move = ctx.pv[0][0];
+            // An interrupted search returns no score, so keep the last one
+            if (!ctx.stopped) result.score = score;
+            result.principal_variation.assign(ctx.pv[0].begin(), ctx.pv[0].begin() + ctx.pv_length[0]);
+            ctx.prev_pv = ctx.pv[0];
+            ctx.prev_pv_length = ctx.pv_length[0];
+        }
+        if (ctx.stopped) break;
+        result.depth = depth;
+
+        // Helpers keep going until the main thread stops them
+        if (!main_thread) continue;
+
+        // A new iteration costs more than all earlier ones together, so
+        // don't start one that is unlikely to finish
+        if (!limits.infinite && elapsed(ctx) * 2 >= limits.max_time) break;
+        if (total_nodes(ctx) >= limits.max_nodes) break;
+        // A mate within the horizon will not change with more depth
+        if (std::abs(score) >= MATE_BOUND && EVAL_CHECKMATE - std::abs(score) <= int32_t(depth)) break;
+    }
+
+    result.nodes_searched = ctx.nodes.load(std::memory_order_relaxed);
+    result.time_elapsed = elapsed(ctx);
+    return result;
+}
+
+// Picks the result to play: each thread votes for its move with weight
+// growing with its depth and with its score above the worst one. A proven
+// mate overrides the vote.
+static const SearchResult& vote(const std::vector<SearchResult>& results) {
+    int32_t min_score = results[0].score;
+    for (const SearchResult& r : results)
+        min_score = std::min(min_score, r.score);
+
+    auto votes = [&](Move move) {
+        int64_t total = 0;
+        for (const SearchResult& r : results) {
+            if (r.best_move == move) total += int64_t(r.score - min_score + 14) * r.depth;
+        }
+        return total;
+    };
+
+    const SearchResult* best = &results[0];
+    for (const SearchResult& r : results) {
+        if (r.depth == 0 || r.best_move == MOVE_NONE) continue;
+        if (best->score >= MATE_BOUND) {
+            if (r.score > best->score) best = &r;
+        } else if (r.score >= MATE_BOUND || (r.score > -MATE_BOUND && votes(r.best_move) > votes(best->best_move))) {
+            best = &r;
+        }
+    }
+    return *best;
+}
+
+SearchResult search(const BoardState& board, const SearchLimits& limits, const MoveStack& game_history,
+                    TranspositionTable& tt) {
+    if (!tt.buckets) tt.resize(TranspositionTable::DEFAULT_MB);
+    tt.new_search();
+
+    MoveList legal;
+    generate_legal_moves(board, legal);
+    if (legal.empty()) {
+        SearchResult result = {};
+        result.score = is_in_check(board) ? -EVAL_CHECKMATE : 0;
+        return result;
+    }
+
+    // Contexts are too big for the stack with their PV tables and move history
+    const int threads = std::max(1, limits.threads);
+    SearchShared shared;
+    std::vector<std::unique_ptr<SearchContext>> contexts;
+    for (int i = 0; i < threads; ++i) {
+        auto ctx = std::make_unique<SearchContext>();
+        ctx->limits = limits;
+        ctx->history = game_history;
+        ctx->tt = &tt;
+        ctx->shared = threads > 1 ? &shared : nullptr;
+        ctx->thread_id = i;
+        shared.threads.push_back(ctx.get());
+        contexts.push_back(std::move(ctx));
+    }
+
+    std::vector<SearchResult> results(threads);
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i) {
+        helpers.emplace_back([&, i] { results[i] = iterative_deepening(board, *contexts[i], legal[0]); });
+    }
+    results[0] = iterative_deepening(board, *contexts[0], legal[0]);
+
+    shared.stop.store(true, std::memory_order_relaxed);
+    for (std::thread& helper : helpers)
+        helper.join();
+
+    SearchResult result = vote(results);
+    result.nodes_searched = total_nodes(*contexts[0]);
+    result.time_elapsed = results[0].time_elapsed;
     return result;
 }
 
 int32_t alpha_beta(BoardState& board, SearchContext& ctx, int32_t alpha, int32_t beta, uint32_t depth) {
-    // TODO: Implement alpha-beta search
-    return 0;
+    if (depth == 0) return quiescence_search(board, ctx, alpha, beta);
+
+    const int ply = ctx.ply;
+    const bool root = ply == 0;
+    const bool pv_node = beta - alpha > 1;
+    const int32_t original_alpha = alpha;
+    ctx.pv_length[ply] = ply;
+
+    count_node(ctx);
+    if (ctx.stopped) return 0;
+
+    if (!root) {
+        if (board.halfmove_clock >= 100 || is_repetition(board, ctx.history)) return 0;
+        if (ply >= MAX_PLY - 1) return evaluate(board);
+
+        // No line from here can beat a shorter mate already found
+        alpha = std::max(alpha, -EVAL_CHECKMATE + ply);
+        beta = std::min(beta, EVAL_CHECKMATE - ply - 1);
+        if (alpha >= beta) return alpha;
+    }
+
+    const bool in_check = is_in_check(board);
+    if (in_check) depth++;
+
+    // PV nodes always search, so the PV reaches the full depth
+    TTEntry entry;
+    const bool tt_hit = ctx.tt->probe(board.hash, entry);
+    if (tt_hit && !pv_node && entry.depth >= int(depth)) {
+        int32_t score = score_from_tt(entry.score, ply);
+        if (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && score >= beta) ||
+            (entry.bound == BOUND_UPPER && score <= alpha))
+            return score;
+    }
+
+    // The hash move first; without one, the previous PV's move while every
+    // move so far repeated that PV
+    const Move pv_move = ctx.follow_pv && ply < ctx.prev_pv_length ? ctx.prev_pv[ply] : MOVE_NONE;
+    const Move first_move = tt_hit && entry.move != MOVE_NONE ? entry.move : pv_move;
+    const Move previous = ctx.history.top >= 0 ? ctx.history.stack[ctx.history.top].move : MOVE_NONE;
+    Move& counter_move = ctx.counter_moves[move_from(previous)][move_to(previous)];
+    MovePicker picker(board, ctx.history_table, first_move, ctx.killers[ply], counter_move);
+
+    int32_t best = -EVAL_INFINITY;
+    Move best_move = MOVE_NONE;
+    int move_count = 0;
+    for (Move move = picker.next(); move != MOVE_NONE; move = picker.next()) {
+        bool quiet = is_quiet(board, move);
+
+        ctx.follow_pv = pv_move != MOVE_NONE && move == pv_move;
+        make_move(board, move, ctx.history);
+        ctx.ply++;
+
+        // Principal variation search: the first move gets the full window,
+        // the rest only need to prove they are no better
+        int32_t score;
+        if (move_count++ == 0) {
+            score = -alpha_beta(board, ctx, -beta, -alpha, depth - 1);
+        } else {
+            score = -alpha_beta(board, ctx, -alpha - 1, -alpha, depth - 1);
+            if (score > alpha && score < beta)
+                score = -alpha_beta(board, ctx, -beta, -alpha, depth - 1);
+        }
+
+        ctx.ply--;
+        unmake_move(board, move, ctx.history);
+        ctx.follow_pv = false;
+        if (ctx.stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move;
+                update_pv(ctx, move);
+                if (score >= beta) {
+                    if (quiet) {
+                        int32_t& entry = ctx.history_table[move_from(move)][move_to(move)];
+                        entry = std::min<int32_t>(entry + depth * depth, HISTORY_MAX);
+                        if (ctx.killers[ply][0] != move) {
+                            ctx.killers[ply][1] = ctx.killers[ply][0];
+                            ctx.killers[ply][0] = move;
+                        }
+                        if (previous != MOVE_NONE) counter_move = move;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    if (move_count == 0) return in_check ? -EVAL_CHECKMATE + ply : 0;
+
+    Bound bound = best >= beta ? BOUND_LOWER : best > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+    ctx.tt->store(board.hash, best_move, score_to_tt(best, ply), EVAL_NONE, depth, bound);
+    return best;
 }
 
+// Captures only, from a static evaluation the side to move can stand on,
+// or every evasion when in check. Results go to the table at depth 0.
 int32_t quiescence_search(BoardState& board, SearchContext& ctx, int32_t alpha, int32_t beta) {
-    // TODO: Implement quiescence search
-    return 0;
+    const int ply = ctx.ply;
+    const bool pv_node = beta - alpha > 1;
+    const int32_t original_alpha = alpha;
+    ctx.pv_length[ply] = ply;
+
+    count_node(ctx);
+    if (ctx.stopped) return 0;
+
+    if (board.halfmove_clock >= 100 || is_repetition(board, ctx.history)) return 0;
+    const bool in_check = is_in_check(board);
+    if (ply >= MAX_PLY - 1) return in_check ? 0 : evaluate(board);
+
+    TTEntry entry;
+    const bool tt_hit = ctx.tt->probe(board.hash, entry);
+    const int32_t tt_score = tt_hit ? score_from_tt(entry.score, ply) : 0;
+    if (tt_hit && !pv_node && entry.bound != BOUND_NONE &&
+        (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && tt_score >= beta) ||
+         (entry.bound == BOUND_UPPER && tt_score <= alpha)))
+        return tt_score;
+
+    // Stand pat: the side to move can usually do at least as well as the
+    // static evaluation by not capturing. The stored eval saves a call, and
+    // a stored score is a better estimate where its bound allows.
+    int32_t static_eval = EVAL_NONE;
+    int32_t best = -EVAL_INFINITY;
+    if (!in_check) {
+        static_eval = tt_hit && entry.eval != EVAL_NONE ? entry.eval : evaluate(board);
+        best = static_eval;
+        if (tt_hit && (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && tt_score > best) ||
+                       (entry.bound == BOUND_UPPER && tt_score < best)))
+            best = tt_score;
+
+        if (best >= beta) {
+            if (!tt_hit)
+                ctx.tt->store(board.hash, MOVE_NONE, score_to_tt(best, ply), static_eval, 0, BOUND_LOWER);
+            return best;
+        }
+        alpha = std::max(alpha, best);
+    }
+
+    const Move tt_move = tt_hit ? entry.move : MOVE_NONE;
+    const Move previous = ctx.history.top >= 0 ? ctx.history.stack[ctx.history.top].move : MOVE_NONE;
+    MovePicker picker = in_check ? MovePicker(board, ctx.history_table, tt_move, ctx.killers[ply],
+                                              ctx.counter_moves[move_from(previous)][move_to(previous)])
+                                 : MovePicker(board, ctx.history_table, tt_move);
+
+    Move best_move = MOVE_NONE;
+    int move_count = 0;
+    for (Move move = picker.next(); move != MOVE_NONE; move = picker.next()) {
+        move_count++;
+
+        // Delta pruning: winning the captured piece with a margin to spare
+        // would still leave the score below alpha
+        if (!in_check && !is_promotion(move)) {
+            uint8_t victim = piece_at(board, move_to(move));
+            int32_t gain = victim != NO_PIECE ? PIECE_VALUES[piece_type(victim)] : PIECE_VALUES[PAWN];
+            if (static_eval + gain + DELTA_MARGIN <= alpha) {
+                best = std::max(best, static_eval + gain + DELTA_MARGIN);
+                continue;
+            }
+        }
+
+        make_move(board, move, ctx.history);
+        ctx.ply++;
+        int32_t score = -quiescence_search(board, ctx, -beta, -alpha);
+        ctx.ply--;
+        unmake_move(board, move, ctx.history);
+        if (ctx.stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move;
+                update_pv(ctx, move);
+                if (score >= beta) break;
+            }
+        }
+    }
+
+    if (in_check && move_count == 0) return -EVAL_CHECKMATE + ply;
+
+    Bound bound = best >= beta ? BOUND_LOWER : pv_node && best > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+    ctx.tt->store(board.hash, best_move, score_to_tt(best, ply), static_eval, 0, bound);
+    return best;
 }
 
 void order_moves(const BoardState& board, std::vector<Move>& moves, Move tt_move) {
-    // TODO: Implement move ordering
+    std::vector<std::pair<int32_t, Move>> scored;
+    scored.reserve(moves.size());
+    for (Move m : moves)
+        scored.push_back({m == tt_move ? INT32_MAX : move_score(board, m), m});
+
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; i < moves.size(); ++i)
+        moves[i] = scored[i].second;
 }
 
-int32_t move_score(const BoardState& board, Move move) {
-    // TODO: Implement move scoring
-    return 0;
+void order_moves(const BoardState& board, MoveList& moves, Move tt_move) {
+    for (uint32_t i = 0; i < moves.size(); ++i)
+        moves.scores[i] = moves[i] == tt_move ? INT32_MAX : move_score(board, moves[i]);
 }
 
 bool should_stop_search(const SearchContext& ctx) {
-    // TODO: Implement search stopping condition
-    return false;
+    if (ctx.shared && ctx.shared->stop.load(std::memory_order_relaxed)) return true;
+    if (total_nodes(ctx) >= ctx.limits.max_nodes) return true;
+    return !ctx.limits.infinite && elapsed(ctx) >= ctx.limits.max_time;
 }
 
 } // namespace chess
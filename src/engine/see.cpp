@@ -0,0 +1,129 @@
+#include "chess/engine/see.hpp"
+#include "chess/engine/eval.hpp"
+#include <algorithm>
+
+namespace chess {
+
+// Least valuable piece type in `attackers`, which must not be empty
+static PieceType least_valuable(const BoardState& board, Bitboard attackers) {
+    for (int type = PAWN; type < KING; ++type) {
+        if (attackers & board.pieces_bb[type]) return PieceType(type);
+    }
+    return KING;
+}
+
+// Sliders that see `square` once `occupied` has lost a piece on the line
+static Bitboard xray_attackers(const BoardState& board, uint8_t square, Bitboard occupied, PieceType removed) {
+    Bitboard result = 0;
+    if (removed == PAWN || removed == BISHOP || removed == QUEEN)
+        result |= get_bishop_attacks(square, occupied) & (board.pieces_bb[BISHOP] | board.pieces_bb[QUEEN]);
+    if (removed == ROOK || removed == QUEEN)
+        result |= get_rook_attacks(square, occupied) & (board.pieces_bb[ROOK] | board.pieces_bb[QUEEN]);
+    return result;
+}
+
+// Value taken by the move itself, plus the occupancy it leaves behind
+static int32_t initial_gain(const BoardState& board, Move move, Bitboard& occupied) {
+    uint8_t to = move_to(move);
+    occupied = board.occupied ^ square_bb(move_from(move));
+
+    int32_t gain = 0;
+    if (move_flags(move) == MOVE_EN_PASSANT) {
+        occupied ^= square_bb(to ^ 8);
+        gain = PIECE_VALUES[PAWN];
+    } else if (piece_at(board, to) != NO_PIECE) {
+        gain = PIECE_VALUES[piece_type(piece_at(board, to))];
+    }
+    if (is_promotion(move))
+        gain += PIECE_VALUES[KNIGHT + move_promotion(move)] - PIECE_VALUES[PAWN];
+    return gain;
+}
+
+// Value of the piece standing on the target square after the move
+static int32_t piece_on_target(const BoardState& board, Move move) {
+    if (is_promotion(move)) return PIECE_VALUES[KNIGHT + move_promotion(move)];
+    return PIECE_VALUES[piece_type(piece_at(board, move_from(move)))];
+}
+
+int32_t see(const BoardState& board, Move move) {
+    if (move_flags(move) == MOVE_CASTLING) return 0;
+
+    uint8_t to = move_to(move);
+    Bitboard occupied;
+    int32_t gain[32];
+    gain[0] = initial_gain(board, move, occupied);
+
+    int32_t on_target = piece_on_target(board, move);
+    Bitboard attackers = attackers_to(board, to, occupied) & occupied;
+    Color side = opposite_color(board.side_to_move);
+
+    // Swap list: gain[d] is the balance for the side making capture d if
+    // the sequence stopped right after it
+    int d = 0;
+    while (d < 31) {
+        Bitboard ours = attackers & board.colors_bb[side];
+        if (!ours) break;
+
+        PieceType type = least_valuable(board, ours);
+        // The king may only take last, onto an undefended square
+        if (type == KING && (attackers & board.colors_bb[opposite_color(side)])) break;
+
+        d++;
+        gain[d] = on_target - gain[d - 1];
+        on_target = PIECE_VALUES[type];
+
+        occupied ^= square_bb(lsb(ours & board.pieces_bb[type]));
+        attackers = (attackers | xray_attackers(board, to, occupied, type)) & occupied;
+        side = opposite_color(side);
+    }
+
+    // Walk back: each side chooses between capturing and standing pat
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+bool see_ge(const BoardState& board, Move move, int32_t threshold) {
+    if (move_flags(move) == MOVE_CASTLING) return threshold <= 0;
+
+    uint8_t to = move_to(move);
+    Bitboard occupied;
+
+    // swap is what the side to move must still win back: fail if even the
+    // free capture does not reach the threshold, succeed if losing the
+    // capturing piece straight away still does
+    int32_t swap = initial_gain(board, move, occupied) - threshold;
+    if (swap < 0) return false;
+    swap = piece_on_target(board, move) - swap;
+    if (swap <= 0) return true;
+
+    Bitboard attackers = attackers_to(board, to, occupied);
+    Color side = board.side_to_move;
+    int result = 1;  // 1 while the mover is ahead of the threshold
+
+    while (true) {
+        side = opposite_color(side);
+        attackers &= occupied;
+        Bitboard ours = attackers & board.colors_bb[side];
+        if (!ours) break;
+
+        // Capturing flips the result; stop once the capturer would be
+        // behind even if its piece survives
+        result ^= 1;
+        PieceType type = least_valuable(board, ours);
+        if (type == KING)
+            return (attackers & board.colors_bb[opposite_color(side)]) ? result ^ 1 : result;
+
+        swap = PIECE_VALUES[type] - swap;
+        if (swap < result) break;
+
+        occupied ^= square_bb(lsb(ours & board.pieces_bb[type]));
+        attackers |= xray_attackers(board, to, occupied, type);
+    }
+
+    return result;
+}
+
+} // namespace chess
@@ -0,0 +1,149 @@
+#include "chess/engine/tt.hpp"
+#include "chess/engine/eval.hpp"
+#include "chess/engine/search.hpp"
+#include <algorithm>
+
+namespace chess {
+
+constexpr int GENERATION_BITS = 6;
+constexpr uint8_t GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+// Scores are kept in 16 bits: mates move to the ends of the range with
+// their distance intact, everything else is clamped below them
+constexpr int32_t TT_MATE = INT16_MAX;
+constexpr int32_t TT_SCORE_LIMIT = TT_MATE - MAX_PLY - 1;
+
+static int16_t pack_score(int32_t score) {
+    if (score >= MATE_BOUND) return int16_t(TT_MATE - (EVAL_CHECKMATE - score));
+    if (score <= -MATE_BOUND) return int16_t(-TT_MATE + (EVAL_CHECKMATE + score));
+    return int16_t(std::clamp(score, -TT_SCORE_LIMIT, TT_SCORE_LIMIT));
+}
+
+static int32_t unpack_score(int16_t packed) {
+    if (packed > TT_SCORE_LIMIT) return EVAL_CHECKMATE - (TT_MATE - packed);
+    if (packed < -TT_SCORE_LIMIT) return -EVAL_CHECKMATE + (TT_MATE + packed);
+    return packed;
+}
+
+static int16_t pack_eval(int32_t eval) {
+    return eval == EVAL_NONE ? INT16_MIN : int16_t(std::clamp<int32_t>(eval, -TT_SCORE_LIMIT, TT_SCORE_LIMIT));
+}
+
+static uint16_t fold(uint64_t data) {
+    return uint16_t(data ^ (data >> 16) ^ (data >> 32) ^ (data >> 48));
+}
+
+static Bound bound_of(uint64_t data) { return Bound(data >> 56 & 3); }
+static uint8_t generation_of(uint64_t data) { return uint8_t(data >> 58); }
+static int depth_of(uint64_t data) { return int(data >> 48 & 0xFF); }
+static Move move_of(uint64_t data) { return Move(data & 0xFFFF); }
+
+void TranspositionTable::resize(size_t megabytes) {
+    buckets.reset();
+    mask = 0;
+
+    size_t count = megabytes * 1024 * 1024 / sizeof(TTBucket);
+    size_t size = 1;
+    while (size * 2 <= count)
+        size *= 2;
+
+    buckets.reset(new TTBucket[size]);
+    mask = size - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; buckets && i <= mask; ++i) {
+        for (int j = 0; j < TTBucket::ENTRIES; ++j) {
+            buckets[i].check[j].store(0, std::memory_order_relaxed);
+            buckets[i].data[j].store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::new_search() {
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const TTBucket& bucket = buckets[key & mask];
+    const uint16_t key16 = uint16_t(key >> 48);
+
+    for (int i = 0; i < TTBucket::ENTRIES; ++i) {
+        uint64_t data = bucket.data[i].load(std::memory_order_relaxed);
+        uint16_t check = bucket.check[i].load(std::memory_order_relaxed);
+        if (bound_of(data) == BOUND_NONE || uint16_t(check ^ fold(data)) != key16) continue;
+
+        int16_t eval = int16_t(data >> 32);
+        entry.move = move_of(data);
+        entry.score = unpack_score(int16_t(data >> 16));
+        entry.eval = eval == INT16_MIN ? EVAL_NONE : eval;
+        entry.depth = depth_of(data);
+        entry.bound = bound_of(data);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int32_t score, int32_t eval, int depth, Bound bound) {
+    TTBucket& bucket = buckets[key & mask];
+    const uint16_t key16 = uint16_t(key >> 48);
+    depth = std::clamp(depth, 0, 255);
+
+    // Same position: refresh it. Otherwise evict the entry that is worth
+    // least, counting each search of age as eight plies of depth.
+    int victim = 0;
+    int worst = INT32_MAX;
+    for (int i = 0; i < TTBucket::ENTRIES; ++i) {
+        uint64_t data = bucket.data[i].load(std::memory_order_relaxed);
+        uint16_t check = bucket.check[i].load(std::memory_order_relaxed);
+
+        if (bound_of(data) != BOUND_NONE && uint16_t(check ^ fold(data)) == key16) {
+            // A much deeper result from this search beats a shallow bound
+            if (bound != BOUND_EXACT && generation_of(data) == generation && depth + 2 < depth_of(data))
+                return;
+            if (move == MOVE_NONE) move = move_of(data);
+            victim = i;
+            break;
+        }
+
+        int age = (generation - generation_of(data)) & GENERATION_MASK;
+        int value = bound_of(data) == BOUND_NONE ? -1 : depth_of(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            victim = i;
+        }
+    }
+
+    uint64_t data = uint64_t(uint16_t(move)) | uint64_t(uint16_t(pack_score(score))) << 16 |
+                    uint64_t(uint16_t(pack_eval(eval))) << 32 | uint64_t(depth) << 48 |
+                    uint64_t(bound) << 56 | uint64_t(generation) << 58;
+    bucket.data[victim].store(data, std::memory_order_relaxed);
+    bucket.check[victim].store(uint16_t(key16 ^ fold(data)), std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    constexpr uint64_t SAMPLE_BUCKETS = 1000 / TTBucket::ENTRIES;
+    uint64_t sampled = std::min<uint64_t>(SAMPLE_BUCKETS, mask + 1);
+
+    int used = 0;
+    for (uint64_t i = 0; buckets && i < sampled; ++i) {
+        for (int j = 0; j < TTBucket::ENTRIES; ++j) {
+            uint64_t data = buckets[i].data[j].load(std::memory_order_relaxed);
+            if (bound_of(data) != BOUND_NONE && generation_of(data) == generation) used++;
+        }
+    }
+    return int(used * 1000 / (sampled * TTBucket::ENTRIES));
+}
+
+TranspositionTable& default_tt() {
+    static TranspositionTable table = [] {
+        TranspositionTable t;
+        t.resize(TranspositionTable::DEFAULT_MB);
+        return t;
+    }();
+    return table;
+}
+
+} // namespace chess
@@ -1,25 +1,161 @@
 #include "chess/parser/fen.hpp"
+#include <sstream>
+#include <cstring>
+#include <cctype>
+#include <vector>
+#include <algorithm>
 
 namespace chess {
 
+static bool is_piece_char(char c) {
+    return c != '\0' && std::strchr("PNBRQKpnbrqk", c) != nullptr;
+}
+
+static bool is_number(const std::string& s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+static std::vector<std::string> split_fields(const std::string& fen) {
+    std::istringstream ss(fen);
+    std::vector<std::string> fields;
+    std::string field;
+    while (ss >> field) fields.push_back(field);
+    return fields;
+}
+
 std::optional<BoardState> parse_fen(const std::string& fen) {
     if (!is_valid_fen(fen)) {
         return std::nullopt;
     }
-    
-    BoardState board = {};
-    // TODO: Implement FEN parsing
+
+    std::vector<std::string> fields = split_fields(fen);
+
+    BoardState board;
+    reset_board(board);
+
+    int rank = 7, file = 0;
+    for (char c : fields[0]) {
+        if (c == '/') {
+            rank--;
+            file = 0;
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            file += c - '0';
+        } else {
+            place_piece(board, rank * 8 + file, char_to_piece(c));
+            file++;
+        }
+    }
+
+    board.side_to_move = fields[1] == "w" ? WHITE : BLACK;
+
+    board.castling_rights = 0;
+    for (char c : fields[2]) {
+        if (c == 'K') board.castling_rights |= CASTLE_WHITE_KING;
+        if (c == 'Q') board.castling_rights |= CASTLE_WHITE_QUEEN;
+        if (c == 'k') board.castling_rights |= CASTLE_BLACK_KING;
+        if (c == 'q') board.castling_rights |= CASTLE_BLACK_QUEEN;
+    }
+
+    board.en_passant_file = fields[3] == "-" ? 8 : fields[3][0] - 'a';
+
+    // The clocks are optional; EPD records stop after the en passant field
+    board.halfmove_clock = fields.size() > 4 ? static_cast<uint8_t>(std::min(std::stoi(fields[4]), 255)) : 0;
+    board.fullmove_number = fields.size() > 5 ? static_cast<uint16_t>(std::max(std::stoi(fields[5]), 1)) : 1;
+
+    board.hash = compute_hash(board);
     return board;
 }
 
 std::string board_to_fen(const BoardState& board) {
-    // TODO: Implement FEN export
-    return "";
+    std::string fen;
+
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            uint8_t piece = piece_at(board, rank * 8 + file);
+            if (piece == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += piece_to_char(piece);
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (rank > 0) fen += '/';
+    }
+
+    fen += board.side_to_move == WHITE ? " w " : " b ";
+
+    if (board.castling_rights == 0) {
+        fen += '-';
+    } else {
+        if (board.castling_rights & CASTLE_WHITE_KING) fen += 'K';
+        if (board.castling_rights & CASTLE_WHITE_QUEEN) fen += 'Q';
+        if (board.castling_rights & CASTLE_BLACK_KING) fen += 'k';
+        if (board.castling_rights & CASTLE_BLACK_QUEEN) fen += 'q';
+    }
+
+    fen += ' ';
+    if (board.en_passant_file < 8) {
+        fen += static_cast<char>('a' + board.en_passant_file);
+        fen += board.side_to_move == WHITE ? '6' : '3';
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ' + std::to_string(board.halfmove_clock) + ' ' + std::to_string(board.fullmove_number);
+    return fen;
 }
 
 bool is_valid_fen(const std::string& fen) {
-    // TODO: Implement FEN validation
-    return !fen.empty();
+    std::vector<std::string> fields = split_fields(fen);
+    if (fields.size() < 4 || fields.size() > 6) return false;
+
+    // Piece placement: eight ranks of eight squares, one king per side
+    int rank = 0, file = 0, white_kings = 0, black_kings = 0;
+    for (char c : fields[0]) {
+        if (c == '/') {
+            if (file != 8) return false;
+            rank++;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else if (is_piece_char(c)) {
+            if (c == 'K') white_kings++;
+            if (c == 'k') black_kings++;
+            file++;
+        } else {
+            return false;
+        }
+        if (file > 8) return false;
+    }
+    if (rank != 7 || file != 8 || white_kings != 1 || black_kings != 1) return false;
+
+    if (fields[1] != "w" && fields[1] != "b") return false;
+
+    if (fields[2] != "-") {
+        if (fields[2].size() > 4) return false;
+        for (char c : fields[2]) {
+            if (c != 'K' && c != 'Q' && c != 'k' && c != 'q') return false;
+        }
+    }
+
+    if (fields[3] != "-") {
+        const std::string& ep = fields[3];
+        char expected_rank = fields[1] == "w" ? '6' : '3';
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || ep[1] != expected_rank) return false;
+    }
+
+    for (size_t i = 4; i < fields.size(); ++i) {
+        if (!is_number(fields[i]) || fields[i].size() > 5) return false;
+    }
+
+    return true;
 }
 
 } // namespace chess
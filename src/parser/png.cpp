@@ -99,7 +99,7 @@ std::vector<PGNGame> parse_pgn_from_file(const std::string& filename) {
         auto move = parse_san(game.starting_position, token);
         if (move) {
             game.moves.push_back(move.value());
-            make_move(game.starting_position, move.value());
+            play_move(game.starting_position, move.value());
         }
     }
     
@@ -213,7 +213,7 @@ std::optional<PGNGame> parse_single_pgn(const std::string& content) {
             auto move = parse_san(game.starting_position, token);
             if (move) {
                 game.moves.push_back(move.value());
-                make_move(game.starting_position, move.value());
+                play_move(game.starting_position, move.value());
             }
         }
     }
@@ -254,7 +254,7 @@ std::string game_to_pgn(const PGNGame& game) {
             ss << " ";
         }
 
-        make_move(board, game.moves[i]);
+        play_move(board, game.moves[i]);
 
         // Add comment if available
         if (i < game.comments.size() && !game.comments[i].empty()) {
@@ -287,7 +287,7 @@ std::string moves_to_pgn(const BoardState& initial_board, const std::vector<Move
             ss << " ";
         }
 
-        make_move(board, moves[i]);
+        play_move(board, moves[i]);
     }
 
     return ss.str();
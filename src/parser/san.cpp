@@ -1,4 +1,5 @@
 #include "chess/parser/san.hpp"
+#include "chess/core/rules.hpp"
 
 namespace chess {
 
@@ -31,51 +32,6 @@ static uint8_t sq_from_file_rank(char f, char r) {
     return (r - '1') * 8 + (f - 'a');
 }
 
-static bool gives_check(BoardState& board, Move m) {
-    make_move(board, m);
-    bool check = is_in_check(board);
-    unmake_move(board, m);
-    return check;
-}
-
-static bool gives_mate(BoardState& board, Move m) {
-    make_move(board, m);
-    if (!is_in_check(board)) {
-        unmake_move(board, m);
-        return false;
-    }
-
-    // if no legal reply exists -> mate
-    for (uint8_t from = 0; from < 64; ++from) {
-        uint8_t p = piece_at(board, from);
-        if (p == NONE || piece_color(p) != board.side_to_move) continue;
-
-        Bitboard attacks = 0;
-        PieceType pt = piece_type(p);
-        if (pt == PAWN) attacks = get_pawn_attacks(from, board.side_to_move);
-        else if (pt == KNIGHT) attacks = get_knight_attacks(from);
-        else if (pt == BISHOP) attacks = get_bishop_attacks(from, board.occupied);
-        else if (pt == ROOK) attacks = get_rook_attacks(from, board.occupied);
-        else if (pt == QUEEN) attacks = get_queen_attacks(from, board.occupied);
-        else if (pt == KING) attacks = get_king_attacks(from);
-
-        while (attacks) {
-            uint8_t to = pop_lsb(attacks);
-            Move reply = make_move(from, to);
-            make_move(board, reply);
-            bool ok = !is_in_check(board);
-            unmake_move(board, reply);
-            if (ok) {
-                unmake_move(board, m);
-                return false;
-            }
-        }
-    }
-
-    unmake_move(board, m);
-    return true;
-}
-
 std::optional<Move> parse_san(const BoardState& board, const std::string& san) {
     std::string s = san;
 
@@ -83,14 +39,18 @@ std::optional<Move> parse_san(const BoardState& board, const std::string& san) {
     if (!s.empty() && (s.back() == '+' || s.back() == '#'))
         s.pop_back();
 
+    MoveList moves;
+    generate_legal_moves(board, moves);
+
     // Castling
-    if (s == "O-O" || s == "0-0") {
-        uint8_t e = board.side_to_move == WHITE ? 4 : 60;
-        return make_move(e, e + 2);
-    }
-    if (s == "O-O-O" || s == "0-0-0") {
-        uint8_t e = board.side_to_move == WHITE ? 4 : 60;
-        return make_move(e, e - 2);
+    bool king_side = s == "O-O" || s == "0-0";
+    bool queen_side = s == "O-O-O" || s == "0-0-0";
+    if (king_side || queen_side) {
+        for (Move m : moves) {
+            if (move_flags(m) == MOVE_CASTLING && (move_to(m) > move_from(m)) == king_side)
+                return m;
+        }
+        return std::nullopt;
     }
 
     size_t idx = 0;
@@ -120,33 +80,19 @@ std::optional<Move> parse_san(const BoardState& board, const std::string& san) {
         promo = letter_to_piece(s[idx + 1]);
     }
 
-    for (uint8_t from = 0; from < 64; ++from) {
-        uint8_t p = piece_at(board, from);
-        if (p == NONE) continue;
-        if (piece_color(p) != board.side_to_move) continue;
-        if (piece_type(p) != pt) continue;
+    // Match against the legal moves, which carry the special-move flags
+    for (Move m : moves) {
+        uint8_t from = move_from(m);
+        if (move_to(m) != to) continue;
+        if (piece_type(piece_at(board, from)) != pt) continue;
 
         if (dis_file && from % 8 != dis_file - 'a') continue;
         if (dis_rank && from / 8 != dis_rank - '1') continue;
 
-        Bitboard attacks = 0;
-        if (pt == PAWN) attacks = get_pawn_attacks(from, board.side_to_move);
-        else if (pt == KNIGHT) attacks = get_knight_attacks(from);
-        else if (pt == BISHOP) attacks = get_bishop_attacks(from, board.occupied);
-        else if (pt == ROOK) attacks = get_rook_attacks(from, board.occupied);
-        else if (pt == QUEEN) attacks = get_queen_attacks(from, board.occupied);
-        else if (pt == KING) attacks = get_king_attacks(from);
+        if (is_promotion(m) != (promo != NONE)) continue;
+        if (is_promotion(m) && KNIGHT + move_promotion(m) != promo) continue;
 
-        if (!(attacks & square_bb(to))) continue;
-
-        Move m = (promo != NONE)
-            ? make_promotion(from, to, promo - KNIGHT)
-            : make_move(from, to);
-
-        BoardState tmp = board;
-        make_move(tmp, m);
-        if (!is_in_check(tmp))
-            return m;
+        return m;
     }
 
     return std::nullopt;
@@ -160,11 +106,10 @@ std::string move_to_san(const BoardState& board, Move move) {
     PieceType pt  = piece_type(piece);
 
     // Castling
-    if (pt == KING && std::abs((int)to - (int)from) == 2) {
+    if (move_flags(move) == MOVE_CASTLING) {
         std::string s = (to > from) ? "O-O" : "O-O-O";
-        BoardState tmp = board;
-        if (gives_mate(tmp, move)) s += "#";
-        else if (gives_check(tmp, move)) s += "+";
+        if (gives_check(board, move))
+            s += gives_mate(board, move) ? "#" : "+";
         return s;
     }
 
@@ -173,31 +118,28 @@ std::string move_to_san(const BoardState& board, Move move) {
     if (pt != PAWN)
         san += piece_letter(pt);
 
-    // Disambiguation
+    // Disambiguation: other pieces of the same kind that can legally reach `to`
     if (pt != PAWN && pt != KING) {
-        bool same_file = false, same_rank = false;
-        for (uint8_t sq = 0; sq < 64; ++sq) {
-            if (sq == from) continue;
-            uint8_t p = piece_at(board, sq);
-            if (p == NONE) continue;
-            if (piece_type(p) == pt && piece_color(p) == piece_color(piece)) {
-                Bitboard attacks = 0;
-                if (pt == KNIGHT) attacks = get_knight_attacks(sq);
-                else if (pt == BISHOP) attacks = get_bishop_attacks(sq, board.occupied);
-                else if (pt == ROOK) attacks = get_rook_attacks(sq, board.occupied);
-                else if (pt == QUEEN) attacks = get_queen_attacks(sq, board.occupied);
-                if (attacks & square_bb(to)) {
-                    if (sq % 8 == from % 8) same_file = true;
-                    if (sq / 8 == from / 8) same_rank = true;
-                }
-            }
+        Bitboard rivals = attackers_to(board, to, board.occupied) & board.pieces_bb[pt] &
+                          board.colors_bb[piece_color(piece)] & ~square_bb(from);
+        bool ambiguous = false, same_file = false, same_rank = false;
+        while (rivals) {
+            uint8_t sq = pop_lsb(rivals);
+            if (!is_legal_move(board, make_move(sq, to))) continue;
+            ambiguous = true;
+            if (sq % 8 == from % 8) same_file = true;
+            if (sq / 8 == from / 8) same_rank = true;
+        }
+        if (ambiguous && !same_file) san += char('a' + from % 8);
+        else if (ambiguous && !same_rank) san += char('1' + from / 8);
+        else if (ambiguous) {
+            san += char('a' + from % 8);
+            san += char('1' + from / 8);
         }
-        if (same_file) san += char('1' + from / 8);
-        else if (same_rank) san += char('a' + from % 8);
     }
 
     // Capture
-    if (piece_at(board, to) != NONE || (pt == PAWN && from % 8 != to % 8)) {
+    if (piece_at(board, to) != NONE || move_flags(move) == MOVE_EN_PASSANT) {
         if (pt == PAWN)
             san += char('a' + from % 8);
         san += 'x';
@@ -207,14 +149,13 @@ std::string move_to_san(const BoardState& board, Move move) {
     san += char('1' + to / 8);
 
     // Promotion
-    if (pt == PAWN && (to / 8 == 0 || to / 8 == 7)) {
+    if (is_promotion(move)) {
         san += '=';
         san += piece_letter(static_cast<PieceType>(move_promotion(move) + KNIGHT));
     }
 
-    BoardState tmp = board;
-    if (gives_mate(tmp, move)) san += "#";
-    else if (gives_check(tmp, move)) san += "+";
+    if (gives_check(board, move))
+        san += gives_mate(board, move) ? "#" : "+";
 
     return san;
 }
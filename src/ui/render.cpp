@@ -167,12 +167,10 @@ void render_move_list(const std::vector<Move>& moves, int columns) {
         
         uint8_t from = move_from(move);
         uint8_t to = move_to(move);
-        uint8_t promo = move_promotion(move);
-        
         std::cout << square_to_string(from) << "-" << square_to_string(to);
         
-        if (promo != 0) {
-            std::cout << "=" << "NBRQ"[promo];
+        if (is_promotion(move)) {
+            std::cout << "=" << "NBRQ"[move_promotion(move)];
         }
         
         std::cout << "  ";
@@ -5,7 +5,19 @@
 #include "chess/core/move.hpp"
 #include "chess/core/piece.hpp"
 #include "chess/core/rules.hpp"
+#include "chess/core/perft.hpp"
+#include "chess/parser/fen.hpp"
+#include "chess/parser/san.hpp"
+#include "chess/engine/eval.hpp"
+#include "chess/engine/pawns.hpp"
+#include "chess/engine/material.hpp"
+#include "chess/engine/movepick.hpp"
+#include "chess/engine/see.hpp"
+#include "chess/engine/search.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <iostream>
 
@@ -46,7 +58,7 @@ TEST_CASE("Basic board setup")
     REQUIRE(board.side_to_move == WHITE);
     REQUIRE(board.fullmove_number == 1);
     REQUIRE(board.en_passant_file == 8);
-    REQUIRE(board.move_stack.empty());
+    REQUIRE(board_history(board).empty());
 
     reset_board(board);
     REQUIRE(board.occupied == 0);
@@ -114,7 +126,7 @@ TEST_CASE("Pawn moves")
     make_move(board, black_double);
     REQUIRE(board.en_passant_file == 3);
 
-    Move ep = make_move(e5, d6);
+    Move ep = make_en_passant(e5, d6);
     make_move(board, ep);
     REQUIRE(piece_at(board, d5) == make_piece(NONE, WHITE)); // captured
     unmake_move(board, ep);
@@ -150,7 +162,7 @@ TEST_CASE("King moves and castling")
     board.castling_rights = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN;
 
     // King-side castle
-    Move k_castle = make_move(4, 6);
+    Move k_castle = make_castling(4, 6);
     make_move(board, k_castle);
     REQUIRE(piece_at(board, 6) == make_piece(KING, WHITE));
     REQUIRE(piece_at(board, 5) == make_piece(ROOK, WHITE));
@@ -159,7 +171,7 @@ TEST_CASE("King moves and castling")
     REQUIRE(piece_at(board, 7) == make_piece(ROOK, WHITE));
 
     // Queen-side castle
-    Move q_castle = make_move(4, 2);
+    Move q_castle = make_castling(4, 2);
     make_move(board, q_castle);
     REQUIRE(piece_at(board, 2) == make_piece(KING, WHITE));
     REQUIRE(piece_at(board, 3) == make_piece(ROOK, WHITE));
@@ -179,13 +191,43 @@ TEST_CASE("Promotions")
     {
         Move m = make_promotion(48, 56, promo);
         make_move(board, m);
-        REQUIRE(piece_type(piece_at(board, 56)) == static_cast<PieceType>(promo));
+        REQUIRE(piece_type(piece_at(board, 56)) == static_cast<PieceType>(KNIGHT + promo));
         unmake_move(board, m);
         REQUIRE(piece_at(board, 48) == make_piece(PAWN, WHITE));
         REQUIRE(piece_at(board, 56) == make_piece(NONE, WHITE));
     }
 }
 
+TEST_CASE("Move flags")
+{
+    // A knight promotion is no longer the same bits as a plain move
+    REQUIRE(make_promotion(a7, a8, KNIGHT - KNIGHT) != make_move(a7, a8));
+    REQUIRE(is_promotion(make_promotion(a7, a8, KNIGHT - KNIGHT)));
+    REQUIRE(!is_promotion(make_move(a7, a8)));
+    REQUIRE(move_promotion(make_promotion(a7, a8, QUEEN - KNIGHT)) == QUEEN - KNIGHT);
+    REQUIRE(move_flags(make_en_passant(e5, d6)) == MOVE_EN_PASSANT);
+    REQUIRE(move_flags(make_castling(e1, g1)) == MOVE_CASTLING);
+    REQUIRE(move_to(make_castling(e1, g1)) == g1);
+
+    // Generated moves carry their flags
+    auto board = parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq a3 0 1");
+    REQUIRE(board);
+    MoveList moves;
+    generate_legal_moves(*board, moves);
+    int castles = 0, en_passant = 0;
+    for (Move m : moves)
+    {
+        castles += move_flags(m) == MOVE_CASTLING;
+        en_passant += move_flags(m) == MOVE_EN_PASSANT;
+        if (move_flags(m) == MOVE_NORMAL)
+            REQUIRE(move_promotion(m) == 0);
+    }
+    REQUIRE(castles == 2);
+    REQUIRE(en_passant == 1);
+    REQUIRE(string_to_move(*board, "e8g8") == make_castling(e8, g8));
+    REQUIRE(string_to_move(*board, "b4a3") == make_en_passant(b4, a3));
+}
+
 TEST_CASE("Check and checkmate detection")
 {
     BoardState board;
@@ -244,6 +286,69 @@ TEST_CASE("Insufficient material draws")
     REQUIRE(is_draw_by_insufficient_material(board));
 }
 
+TEST_CASE("Move clocks, repetition and fifty-move draws")
+{
+    BoardState board;
+    init_board(board);
+    MoveStack history;
+
+    auto play = [&](const char *uci)
+    {
+        Move m = string_to_move(board, uci);
+        MoveList legal;
+        generate_legal_moves(board, legal);
+        for (Move l : legal)
+            if (move_from(l) == move_from(m) && move_to(l) == move_to(m))
+                m = l;
+        make_move(board, m, history);
+    };
+
+    play("e2e4");
+    REQUIRE(board.halfmove_clock == 0);
+    REQUIRE(board.fullmove_number == 1);
+    play("g8f6");
+    REQUIRE(board.halfmove_clock == 1);
+    REQUIRE(board.fullmove_number == 2);
+
+    // Knights out and back: the position after e4 Nf6 comes back every 4 plies
+    const char *shuffle[] = {"g1f3", "f6g8", "f3g1", "g8f6"};
+    for (const char *m : shuffle)
+    {
+        REQUIRE_FALSE(is_repetition(board, history));
+        play(m);
+    }
+    REQUIRE(is_repetition(board, history));
+    REQUIRE(count_repetitions(board, history) == 1);
+    REQUIRE(check_game_result(board, history) == IN_PROGRESS);
+
+    for (const char *m : shuffle)
+        play(m);
+    REQUIRE(count_repetitions(board, history) == 2);
+    REQUIRE(check_game_result(board, history) == DRAW_REPETITION);
+    REQUIRE(board.halfmove_clock == 9);
+    REQUIRE(board.fullmove_number == 6);
+
+    // Unmaking restores both clocks
+    unmake_move(board, history.stack[history.top].move, history);
+    REQUIRE(board.halfmove_clock == 8);
+    REQUIRE(board.fullmove_number == 5);
+    unmake_move(board, history.stack[history.top].move, history);
+    REQUIRE(board.halfmove_clock == 7);
+    REQUIRE(board.fullmove_number == 5);
+
+    // A pawn move resets the clock, so nothing before it is looked at
+    play("d2d4");
+    REQUIRE(board.halfmove_clock == 0);
+    REQUIRE_FALSE(is_repetition(board, history));
+
+    auto fifty = parse_fen("4k3/8/8/8/8/8/4P3/R3K3 w - - 99 80");
+    REQUIRE(fifty);
+    REQUIRE(check_game_result(*fifty) == IN_PROGRESS);
+    make_move(*fifty, make_move(0, 1));
+    REQUIRE(fifty->halfmove_clock == 100);
+    REQUIRE(check_game_result(*fifty) == DRAW_FIFTY_MOVE);
+}
+
 TEST_CASE("Attack maps")
 {
     BoardState board;
@@ -281,7 +386,7 @@ TEST_CASE("Move unmake complex scenario")
 
     // e5 x d6 en passant
 
-    Move ep = make_move(36, 43);
+    Move ep = make_en_passant(36, 43);
     make_move(board, ep);
 
     REQUIRE(piece_at(board, 43) == make_piece(PAWN, WHITE));
@@ -304,3 +409,1045 @@ TEST_CASE("Move unmake complex scenario")
     unmake_move(board, w1);
     REQUIRE(piece_at(board, 12) == make_piece(PAWN, WHITE));
 }
+
+static Bitboard walk_rays(uint8_t square, Bitboard occupied, const int (&dirs)[4][2])
+{
+    Bitboard attacks = 0;
+    for (const auto &d : dirs)
+    {
+        for (int r = square / 8 + d[0], f = square % 8 + d[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += d[0], f += d[1])
+        {
+            attacks |= square_bb(r * 8 + f);
+            if (occupied & square_bb(r * 8 + f))
+                break;
+        }
+    }
+    return attacks;
+}
+
+TEST_CASE("Magic slider attacks match ray walking")
+{
+    const int rook_dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    const int bishop_dirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 20000; ++i)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        Bitboard occupied = seed & (seed >> 3);
+        uint8_t sq = i % 64;
+
+        REQUIRE(get_rook_attacks(sq, occupied) == walk_rays(sq, occupied, rook_dirs));
+        REQUIRE(get_bishop_attacks(sq, occupied) == walk_rays(sq, occupied, bishop_dirs));
+    }
+
+    REQUIRE(get_rook_attacks(a1, 0) == ((0xFFULL | 0x0101010101010101ULL) & ~square_bb(a1)));
+    REQUIRE(get_queen_attacks(d4, square_bb(d5) | square_bb(e5)) ==
+            (get_rook_attacks(d4, square_bb(d5)) | get_bishop_attacks(d4, square_bb(e5))));
+}
+
+// Evaluated during this file's static initialization, before main() and in
+// no particular order with attacks.cpp
+static const Bitboard ROOK_A1_BEFORE_MAIN = get_rook_attacks(a1, 0);
+
+TEST_CASE("Slider tables are ready before main")
+{
+    REQUIRE(ROOK_A1_BEFORE_MAIN == ((0xFFULL | 0x0101010101010101ULL) & ~square_bb(a1)));
+}
+
+template <SliderBackend Backend>
+static void check_slider_backend()
+{
+    if (!slider_backend_supported(Backend))
+        return;
+
+    static Magic rook[64], bishop[64];
+    std::vector<Bitboard> storage(SLIDER_TABLE_SIZE);
+    fill_slider_tables(Backend, rook, bishop, storage.data());
+
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 4096; ++i)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        const Magic &r = rook[i % 64];
+        const Magic &b = bishop[i % 64];
+        REQUIRE(r.attacks[r.index<Backend>(seed)] == get_rook_attacks(i % 64, seed));
+        REQUIRE(b.attacks[b.index<Backend>(seed)] == get_bishop_attacks(i % 64, seed));
+    }
+}
+
+TEST_CASE("Slider backends agree")
+{
+    check_slider_backend<SliderBackend::MAGIC>();
+    check_slider_backend<SliderBackend::PEXT>();
+}
+
+TEST_CASE("Leaper and ray tables")
+{
+    static_assert(get_knight_attacks(a1) == (square_bb(b3) | square_bb(c2)), "knight table is compile-time");
+
+    REQUIRE(pop_count(get_knight_attacks(e4)) == 8);
+    REQUIRE(pop_count(get_king_attacks(h8)) == 3);
+    REQUIRE(get_pawn_attacks(a2, WHITE) == square_bb(b3));
+    REQUIRE(get_pawn_attacks(e5, BLACK) == (square_bb(d4) | square_bb(f4)));
+
+    REQUIRE(BETWEEN[a1][d4] == (square_bb(b2) | square_bb(c3)));
+    REQUIRE(BETWEEN[e1][e8] == (square_bb(e2) | square_bb(e3) | square_bb(e4) | square_bb(e5) | square_bb(e6) | square_bb(e7)));
+    REQUIRE(BETWEEN[a1][b3] == 0);
+    REQUIRE(BETWEEN[a1][b2] == 0);
+
+    REQUIRE(LINE[c3][e5] == 0x8040201008040201ULL);
+    REQUIRE(LINE[a4][c4] == 0xFFULL << 24);
+    REQUIRE(LINE[a1][b3] == 0);
+}
+
+static bool mailbox_in_sync(const BoardState &board)
+{
+    for (uint8_t sq = 0; sq < 64; ++sq)
+    {
+        uint8_t piece = piece_at(board, sq);
+        if (piece == NO_PIECE)
+        {
+            if (board.occupied & square_bb(sq))
+                return false;
+            continue;
+        }
+        if (!(board.pieces_bb[piece_type(piece)] & board.colors_bb[piece_color(piece)] & square_bb(sq)))
+            return false;
+    }
+    return pop_count(board.occupied) == pop_count(board.colors_bb[WHITE] | board.colors_bb[BLACK]);
+}
+
+TEST_CASE("Mailbox stays in sync with bitboards")
+{
+    BoardState board;
+    MoveStack history;
+    init_board(board);
+    REQUIRE(mailbox_in_sync(board));
+    REQUIRE(piece_at(board, e1) == make_piece(KING, WHITE));
+    REQUIRE(piece_at(board, d8) == make_piece(QUEEN, BLACK));
+    REQUIRE(piece_at(board, e4) == NO_PIECE);
+
+    const Move line[] = {make_move(e2, e4), make_move(d7, d5), make_move(e4, d5), make_move(d8, d5),
+                         make_move(b1, c3), make_move(d5, a2), make_move(a1, a2)};
+    for (Move m : line)
+    {
+        make_move(board, m, history);
+        REQUIRE(mailbox_in_sync(board));
+    }
+    for (int i = 6; i >= 0; --i)
+    {
+        unmake_move(board, line[i], history);
+        REQUIRE(mailbox_in_sync(board));
+    }
+
+    BoardState start;
+    init_board(start);
+    REQUIRE(board.mailbox == start.mailbox);
+}
+
+TEST_CASE("Zobrist hash is updated incrementally")
+{
+    BoardState board;
+    MoveStack history;
+    init_board(board);
+    const uint64_t start_hash = board.hash;
+    REQUIRE(start_hash != 0);
+    REQUIRE(start_hash == compute_hash(board));
+
+    // Knights out and back: same position, same hash
+    const Move shuffle[] = {make_move(g1, f3), make_move(g8, f6), make_move(f3, g1), make_move(f6, g8)};
+    for (Move m : shuffle)
+    {
+        make_move(board, m, history);
+        REQUIRE(board.hash == compute_hash(board));
+    }
+    REQUIRE(board.hash == start_hash);
+
+    // Transposition reached by a different move order
+    BoardState a, b;
+    init_board(a);
+    init_board(b);
+    for (Move m : {make_move(g1, f3), make_move(g8, f6), make_move(b1, c3), make_move(b8, c6)})
+        make_move(a, m);
+    for (Move m : {make_move(b1, c3), make_move(b8, c6), make_move(g1, f3), make_move(g8, f6)})
+        make_move(b, m);
+    REQUIRE(a.hash == b.hash);
+
+    // Side to move, en passant file and castling rights are all keyed
+    BoardState c;
+    init_board(c);
+    make_move(c, make_move(e2, e4), history);
+    REQUIRE(c.hash == compute_hash(c));
+    unmake_move(c, make_move(e2, e4), history);
+    REQUIRE(c.hash == start_hash);
+
+    make_move(c, make_move(e2, e3), history);
+    make_move(c, make_move(e7, e6), history);
+    make_move(c, make_move(e1, e2), history);
+    REQUIRE(c.castling_rights == (CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN));
+    REQUIRE(c.hash == compute_hash(c));
+
+    // A move for the side not to move keeps the side and its key in step
+    BoardState d;
+    init_board(d);
+    const uint64_t before = d.hash;
+    make_move(d, make_move(e7, e5), history);
+    REQUIRE(d.side_to_move == WHITE);
+    REQUIRE(d.hash == compute_hash(d));
+    unmake_move(d, make_move(e7, e5), history);
+    REQUIRE(d.side_to_move == WHITE);
+    REQUIRE(d.hash == before);
+}
+
+TEST_CASE("MoveList generators match vector generators")
+{
+    BoardState board;
+    init_board(board);
+
+    MoveList list;
+    generate_legal_moves(board, list);
+    REQUIRE(list.size() == 20);
+
+    std::vector<Move> vec;
+    generate_legal_moves(board, vec);
+    REQUIRE(std::vector<Move>(list.begin(), list.end()) == vec);
+
+    int knight_moves = 0;
+    for (Move m : list)
+        if (piece_type(piece_at(board, move_from(m))) == KNIGHT)
+            ++knight_moves;
+    REQUIRE(knight_moves == 4);
+
+    list.scores[0] = 42;
+    REQUIRE(list.scores[0] == 42);
+
+    generate_captures(board, list);
+    REQUIRE(list.empty());
+}
+
+static uint64_t count_leaves(BoardState &board, int depth)
+{
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    for (Move m : moves)
+    {
+        UndoInfo undo;
+        make_move(board, m, undo);
+        nodes += count_leaves(board, depth - 1);
+        unmake_move(board, m, undo);
+    }
+    return nodes;
+}
+
+static bool has_move(const MoveList &moves, Move m)
+{
+    for (Move x : moves)
+        if (x == m)
+            return true;
+    return false;
+}
+
+TEST_CASE("Legal generator: start position counts")
+{
+    BoardState board;
+    init_board(board);
+    REQUIRE(count_leaves(board, 1) == 20);
+    REQUIRE(count_leaves(board, 2) == 400);
+    REQUIRE(count_leaves(board, 3) == 8902);
+}
+
+TEST_CASE("Legal generator: pins, checks, castling, promotions, en passant")
+{
+    MoveList moves;
+
+    // Bishop pinned on the e-file cannot move, king must not step onto the file
+    BoardState board;
+    reset_board(board);
+    place_piece(board, e1, make_piece(KING, WHITE));
+    place_piece(board, e2, make_piece(BISHOP, WHITE));
+    place_piece(board, e8, make_piece(ROOK, BLACK));
+    place_piece(board, a8, make_piece(KING, BLACK));
+    generate_legal_moves(board, moves);
+    for (Move m : moves)
+        REQUIRE(move_from(m) == e1);
+    REQUIRE(moves.size() == 4); // d1 d2 f1 f2
+
+    // Check by a rook: block or capture, and castling is illegal
+    reset_board(board);
+    place_piece(board, e1, make_piece(KING, WHITE));
+    place_piece(board, h1, make_piece(ROOK, WHITE));
+    place_piece(board, c3, make_piece(KNIGHT, WHITE));
+    place_piece(board, e8, make_piece(ROOK, BLACK));
+    place_piece(board, a8, make_piece(KING, BLACK));
+    board.castling_rights = CASTLE_WHITE_KING;
+    generate_legal_moves(board, moves);
+    REQUIRE(has_move(moves, make_move(c3, e2)));
+    REQUIRE(has_move(moves, make_move(c3, e4)));
+    REQUIRE(!has_move(moves, make_move(c3, d5)));
+    REQUIRE(!has_move(moves, make_castling(e1, g1)));
+
+    // Castling through an attacked square
+    reset_board(board);
+    place_piece(board, e1, make_piece(KING, WHITE));
+    place_piece(board, h1, make_piece(ROOK, WHITE));
+    place_piece(board, a1, make_piece(ROOK, WHITE));
+    place_piece(board, f8, make_piece(ROOK, BLACK));
+    place_piece(board, a8, make_piece(KING, BLACK));
+    board.castling_rights = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN;
+    generate_legal_moves(board, moves);
+    REQUIRE(!has_move(moves, make_castling(e1, g1)));
+    REQUIRE(has_move(moves, make_castling(e1, c1)));
+
+    // All four promotions, queen first
+    reset_board(board);
+    place_piece(board, a1, make_piece(KING, WHITE));
+    place_piece(board, b7, make_piece(PAWN, WHITE));
+    place_piece(board, h8, make_piece(KING, BLACK));
+    generate_legal_moves(board, moves);
+    REQUIRE(has_move(moves, make_promotion(b7, b8, QUEEN - KNIGHT)));
+    REQUIRE(has_move(moves, make_promotion(b7, b8, KNIGHT - KNIGHT)));
+    REQUIRE(string_to_move(board, "b7b8") == make_promotion(b7, b8, QUEEN - KNIGHT));
+    REQUIRE(string_to_move(board, "b7b8n") == make_promotion(b7, b8, KNIGHT - KNIGHT));
+
+    // En passant that would expose the king along the rank
+    reset_board(board);
+    place_piece(board, a5, make_piece(KING, WHITE));
+    place_piece(board, e5, make_piece(PAWN, WHITE));
+    place_piece(board, d7, make_piece(PAWN, BLACK));
+    place_piece(board, h5, make_piece(ROOK, BLACK));
+    place_piece(board, h8, make_piece(KING, BLACK));
+    board.side_to_move = BLACK;
+    make_move(board, make_move(d7, d5));
+    generate_legal_moves(board, moves);
+    REQUIRE(!has_move(moves, make_en_passant(e5, d6)));
+}
+
+TEST_CASE("Generation types partition the legal moves")
+{
+    BoardState board;
+    init_board(board);
+    MoveStack history;
+    MoveList all, captures, quiets, evasions;
+
+    // Walk a deterministic game and compare the subsets at every ply
+    for (int ply = 0; ply < 60; ++ply)
+    {
+        generate_legal_moves(board, all);
+        if (all.empty())
+            break;
+        generate_moves(board, GEN_CAPTURES, captures);
+        generate_moves(board, GEN_QUIETS, quiets);
+        REQUIRE(captures.size() + quiets.size() == all.size());
+
+        for (Move m : captures)
+        {
+            REQUIRE(has_move(all, m));
+            REQUIRE(!has_move(quiets, m));
+        }
+        for (Move m : quiets)
+        {
+            REQUIRE(has_move(all, m));
+            REQUIRE(piece_at(board, move_to(m)) == NO_PIECE);
+        }
+
+        if (is_in_check(board))
+        {
+            generate_moves(board, GEN_EVASIONS, evasions);
+            REQUIRE(evasions.size() == all.size());
+        }
+
+        // Prefer captures so the walk reaches tactical positions
+        Move m = captures.empty() ? all[(ply * 7) % all.size()] : captures[0];
+        make_move(board, m, history);
+    }
+}
+
+TEST_CASE("FEN round trip")
+{
+    const char *fens[] = {
+        STARTING_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 12 40",
+    };
+    for (const char *fen : fens)
+    {
+        auto board = parse_fen(fen);
+        REQUIRE(board);
+        REQUIRE(board_to_fen(*board) == fen);
+        REQUIRE(board->hash == compute_hash(*board));
+        REQUIRE(mailbox_in_sync(*board));
+    }
+
+    BoardState start;
+    init_board(start);
+    REQUIRE(parse_fen(STARTING_FEN)->hash == start.hash);
+
+    REQUIRE(!parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1"));
+    REQUIRE(!parse_fen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    REQUIRE(!parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+    REQUIRE(!parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4 0 1"));
+}
+
+TEST_CASE("Perft: Kiwipete, divide and cache")
+{
+    auto board = parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    REQUIRE(board);
+    const uint64_t before = board->hash;
+
+    REQUIRE(perft(*board, 1) == 48);
+    REQUIRE(perft(*board, 2) == 2039);
+    REQUIRE(perft(*board, 3) == 97862);
+
+    PerftOptions no_bulk;
+    no_bulk.bulk = false;
+    REQUIRE(perft(*board, 2, no_bulk) == 2039);
+
+    PerftCache cache;
+    cache.resize(1);
+    PerftOptions cached;
+    cached.cache = &cache;
+    REQUIRE(perft(*board, 3, cached) == 97862);
+    REQUIRE(perft(*board, 3, cached) == 97862);
+    REQUIRE(cache.hits > 0);
+
+    uint64_t total = 0;
+    auto divide = perft_divide(*board, 3);
+    REQUIRE(divide.size() == 48);
+    for (const PerftDivide &entry : divide)
+        total += entry.nodes;
+    REQUIRE(total == 97862);
+
+    REQUIRE(board->hash == before);
+}
+
+TEST_CASE("Parallel perft matches serial counts")
+{
+    auto board = parse_fen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+    REQUIRE(board);
+
+    PerftCache cache;
+    cache.resize(1);
+    PerftOptions cached;
+    cached.cache = &cache;
+
+    for (int threads : {1, 2, 4})
+    {
+        std::vector<PerftThreadStats> stats;
+        REQUIRE(perft_parallel(*board, 5, threads, PerftOptions(), &stats) == 674624);
+        REQUIRE(stats.size() == size_t(threads));
+
+        uint64_t nodes = 0;
+        for (const PerftThreadStats &s : stats)
+            nodes += s.nodes;
+        REQUIRE(nodes == 674624);
+
+        cache.clear();
+        REQUIRE(perft_parallel(*board, 5, threads, cached) == 674624);
+    }
+}
+
+static bool psqt_in_sync(const BoardState &board)
+{
+    int mg = 0, eg = 0, phase = 0;
+    for (uint8_t sq = 0; sq < 64; ++sq)
+    {
+        uint8_t piece = piece_at(board, sq);
+        if (piece == NO_PIECE)
+            continue;
+        mg += PSQT_MG[piece][sq];
+        eg += PSQT_EG[piece][sq];
+        phase += PHASE_WEIGHTS[piece];
+    }
+    return board.psqt_mg == mg && board.psqt_eg == eg && board.phase == phase;
+}
+
+TEST_CASE("Material, PST and phase sums are updated incrementally")
+{
+    BoardState board;
+    init_board(board);
+    REQUIRE(psqt_in_sync(board));
+    REQUIRE(board.phase == 24);
+    REQUIRE(evaluate(board) == 0); // symmetric position
+
+    // Every kind of move, including promotions and castling, then undo it
+    auto kiwipete = parse_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    REQUIRE(kiwipete);
+    BoardState copy = *kiwipete;
+    MoveList moves;
+    generate_legal_moves(copy, moves);
+    for (Move m : moves)
+    {
+        UndoInfo undo;
+        make_move(copy, m, undo);
+        REQUIRE(psqt_in_sync(copy));
+
+        MoveList replies;
+        generate_legal_moves(copy, replies);
+        for (Move r : replies)
+        {
+            UndoInfo reply_undo;
+            make_move(copy, r, reply_undo);
+            REQUIRE(psqt_in_sync(copy));
+            unmake_move(copy, r, reply_undo);
+        }
+
+        unmake_move(copy, m, undo);
+    }
+    REQUIRE(copy.psqt_mg == kiwipete->psqt_mg);
+    REQUIRE(copy.psqt_eg == kiwipete->psqt_eg);
+    REQUIRE(copy.phase == kiwipete->phase);
+
+    // Scores are from the side to move's point of view
+    auto up_a_queen = parse_fen("4k3/8/8/8/8/8/8/3QK3 w - - 0 1");
+    REQUIRE(up_a_queen);
+    REQUIRE(evaluate(*up_a_queen) > 800);
+    up_a_queen->side_to_move = BLACK;
+    REQUIRE(evaluate(*up_a_queen) < -800);
+    REQUIRE(get_game_phase(*up_a_queen) == 4);
+}
+
+TEST_CASE("Pawn key and pawn hash table")
+{
+    auto board = parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    REQUIRE(board);
+    REQUIRE(board->pawn_key == compute_pawn_key(*board));
+
+    // Piece moves leave the pawn key alone, pawn and king moves change it
+    MoveList moves;
+    generate_legal_moves(*board, moves);
+    for (Move m : moves)
+    {
+        UndoInfo undo;
+        uint64_t before = board->pawn_key;
+        PieceType moved = piece_type(piece_at(*board, move_from(m)));
+        uint8_t captured = piece_at(*board, move_to(m));
+        make_move(*board, m, undo);
+        REQUIRE(board->pawn_key == compute_pawn_key(*board));
+        bool structural = moved == PAWN || moved == KING || (captured != NO_PIECE && piece_type(captured) == PAWN);
+        REQUIRE((board->pawn_key != before) == structural);
+        unmake_move(*board, m, undo);
+        REQUIRE(board->pawn_key == before);
+    }
+
+    // Isolated, doubled and passed pawns
+    auto structure = parse_fen("4k3/8/8/3P4/8/2P5/2P5/4K3 w - - 0 1");
+    REQUIRE(structure);
+    PawnEntry entry = evaluate_pawns(*structure);
+    REQUIRE(entry.passed[WHITE] == (square_bb(d5) | square_bb(c3) | square_bb(c2)));
+    REQUIRE(entry.passed[BLACK] == 0);
+    REQUIRE(entry.eg > 0);
+
+    auto mirrored = parse_fen("4k3/2p5/2p5/8/3p4/8/8/4K3 b - - 0 1");
+    REQUIRE(mirrored);
+    REQUIRE(evaluate_pawns(*mirrored).mg == -entry.mg);
+    REQUIRE(evaluate_pawns(*mirrored).eg == -entry.eg);
+    REQUIRE(evaluate_pawn_structure(*structure) == evaluate_pawn_structure(*mirrored));
+
+    // Second probe of the same structure is a hit with the same content
+    PawnTable table;
+    const PawnEntry &first = table.probe(*structure);
+    REQUIRE(table.hits == 0);
+    const PawnEntry &second = table.probe(*structure);
+    REQUIRE(table.hits == 1);
+    REQUIRE(second.mg == first.mg);
+    REQUIRE(second.passed[WHITE] == entry.passed[WHITE]);
+}
+
+TEST_CASE("Material key and endgame dispatch")
+{
+    BoardState board;
+    init_board(board);
+    REQUIRE(board.material_key == compute_material_key(board));
+    REQUIRE(material_count(board.material_key, PAWN, WHITE) == 8);
+    REQUIRE(material_count(board.material_key, QUEEN, BLACK) == 1);
+
+    // Captures and promotions change the signature, everything else keeps it
+    auto promo = parse_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    REQUIRE(promo);
+    MoveList moves;
+    generate_legal_moves(*promo, moves);
+    for (Move m : moves)
+    {
+        UndoInfo undo;
+        uint64_t before = promo->material_key;
+        bool changes = piece_at(*promo, move_to(m)) != NO_PIECE || is_promotion(m) ||
+                       move_flags(m) == MOVE_EN_PASSANT;
+        make_move(*promo, m, undo);
+        REQUIRE(promo->material_key == compute_material_key(*promo));
+        REQUIRE((promo->material_key != before) == changes);
+        unmake_move(*promo, m, undo);
+    }
+
+    auto entry_for = [](const char *fen)
+    {
+        return analyse_material(parse_fen(fen)->material_key);
+    };
+    REQUIRE(entry_for("4k3/8/8/8/8/8/8/3QK3 w - - 0 1").evaluator == evaluate_kxk);
+    REQUIRE(entry_for("4k3/8/8/8/8/8/8/3RK3 b - - 0 1").evaluator == evaluate_kxk);
+    REQUIRE(entry_for("4k3/8/8/8/8/8/8/2BNK3 w - - 0 1").evaluator == evaluate_kbnk);
+    REQUIRE(entry_for("4k3/8/8/8/8/8/4p3/4K3 w - - 0 1").evaluator == evaluate_kpk);
+    REQUIRE(entry_for("4k3/8/8/8/8/8/4p3/4K3 w - - 0 1").strong_side == BLACK);
+    REQUIRE(entry_for(STARTING_FEN).evaluator == nullptr);
+    REQUIRE(entry_for(STARTING_FEN).phase == 24);
+
+    // Rook against bishop without pawns is scaled down for the rook side
+    MaterialEntry rook_vs_bishop = entry_for("4k3/8/8/8/8/8/3b4/3RK3 w - - 0 1");
+    REQUIRE(rook_vs_bishop.evaluator == nullptr);
+    REQUIRE(rook_vs_bishop.scale[WHITE] < SCALE_NORMAL);
+
+    // Mop-up prefers the defending king on the edge, KBNK the right corner
+    auto centre = parse_fen("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+    auto edge = parse_fen("3k4/8/8/8/4K3/8/8/R7 w - - 0 1");  // same king distance
+    REQUIRE(evaluate(*centre) > KNOWN_WIN);
+    REQUIRE(evaluate(*edge) > evaluate(*centre));
+
+    auto right_corner = parse_fen("7k/8/6K1/8/8/8/8/2BN4 w - - 0 1");  // dark bishop, h8
+    auto wrong_corner = parse_fen("k7/8/1K6/8/8/8/8/2BN4 w - - 0 1");
+    REQUIRE(evaluate(*right_corner) > evaluate(*wrong_corner));
+
+    // KPK: won with the king on a key square, drawish with the defender in front
+    auto key_square = parse_fen("3k4/8/3K4/8/3P4/8/8/8 b - - 0 1");
+    auto blockade = parse_fen("3k4/8/8/3P4/3K4/8/8/8 w - - 0 1");
+    auto rook_pawn = parse_fen("k7/8/8/8/8/8/P7/K7 w - - 0 1");
+    REQUIRE(evaluate(*key_square) < -KNOWN_WIN);
+    REQUIRE(evaluate(*blockade) < 50);
+    REQUIRE(evaluate(*rook_pawn) == 0);
+}
+
+TEST_CASE("attackers_to and static exchange evaluation")
+{
+    BoardState board;
+    init_board(board);
+    // f3 is covered by the e2 and g2 pawns and the g1 knight
+    REQUIRE(attackers_to(board, 21, board.occupied) == (square_bb(12) | square_bb(14) | square_bb(6)));
+    // Without the e2 pawn the f1 bishop can't reach f3, but the d1 queen
+    // sees e2 once it is gone
+    REQUIRE(test_bit(attackers_to(board, 12, board.occupied ^ square_bb(12)), 3));
+
+    auto see_of = [](const char *fen, const char *uci)
+    {
+        auto position = parse_fen(fen);
+        return see(*position, string_to_move(*position, uci));
+    };
+    // Undefended pawn
+    REQUIRE(see_of("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5") == PIECE_VALUES[PAWN]);
+    // Long exchange that ends with knight for pawn
+    REQUIRE(see_of("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5") ==
+            PIECE_VALUES[PAWN] - PIECE_VALUES[KNIGHT]);
+    // The second rook only joins through the x-ray
+    REQUIRE(see_of("4k3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", "d2d5") == PIECE_VALUES[PAWN]);
+    REQUIRE(see_of("3rk3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", "d2d5") == PIECE_VALUES[PAWN] - PIECE_VALUES[ROOK]);
+    // The king recaptures only when nothing defends the square
+    REQUIRE(see_of("8/8/3k4/3p4/8/8/3R4/4K3 w - - 0 1", "d2d5") == PIECE_VALUES[PAWN] - PIECE_VALUES[ROOK]);
+    REQUIRE(see_of("8/8/3k4/3p4/4P3/8/3R4/4K3 w - - 0 1", "d2d5") == PIECE_VALUES[PAWN]);
+
+    // see_ge agrees with see for every capture and promotion
+    for (const char *fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"})
+    {
+        auto position = parse_fen(fen);
+        MoveList captures;
+        generate_moves(*position, GEN_CAPTURES, captures);
+        for (Move m : captures)
+        {
+            int32_t value = see(*position, m);
+            for (int32_t threshold : {-1000, -300, -100, 0, 1, 100, 250, 1000})
+                REQUIRE(see_ge(*position, m, threshold) == (value >= threshold));
+        }
+    }
+}
+
+TEST_CASE("gives_check matches playing the move")
+{
+    // Walks a few plies of positions rich in discovered checks, promotions,
+    // en passant and castling
+    std::function<void(BoardState &, int)> walk = [&](BoardState &board, int depth)
+    {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        CheckInfo info = compute_check_info(board);
+        for (Move m : moves)
+        {
+            UndoInfo undo;
+            bool predicted = gives_check(board, m, info);
+            make_move(board, m, undo);
+            REQUIRE(predicted == is_in_check(board));
+            if (depth > 1)
+                walk(board, depth - 1);
+            unmake_move(board, m, undo);
+        }
+    };
+
+    for (const char *fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                            "5k2/8/8/8/8/8/8/4K2R w K - 0 1"})
+    {
+        auto board = parse_fen(fen);
+        REQUIRE(board);
+        walk(*board, 3);
+    }
+
+    auto mate = parse_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    REQUIRE(gives_mate(*mate, string_to_move(*mate, "a1a8")));
+    REQUIRE_FALSE(gives_mate(*mate, string_to_move(*mate, "a1a7")));
+    REQUIRE(move_to_san(*mate, string_to_move(*mate, "a1a8")) == "Ra8#");
+    auto castle = parse_fen("5k2/8/8/8/8/8/8/4K2R w K - 0 1");
+    REQUIRE(move_to_san(*castle, string_to_move(*castle, "e1g1")) == "O-O+");
+}
+
+TEST_CASE("Legal move counting and early exit")
+{
+    std::function<void(BoardState &, int)> walk = [&](BoardState &board, int depth)
+    {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        REQUIRE(count_legal_moves(board) == int(moves.size()));
+        REQUIRE(has_any_legal_move(board) == !moves.empty());
+        if (depth == 0)
+            return;
+        for (Move m : moves)
+        {
+            UndoInfo undo;
+            make_move(board, m, undo);
+            walk(board, depth - 1);
+            unmake_move(board, m, undo);
+        }
+    };
+
+    for (const char *fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"})
+    {
+        auto board = parse_fen(fen);
+        REQUIRE(board);
+        walk(*board, 2);
+    }
+
+    BoardState board;
+    init_board(board);
+    REQUIRE(count_legal_moves(board) == 20);
+
+    auto mated = parse_fen("R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1");
+    auto stalemated = parse_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    REQUIRE_FALSE(has_any_legal_move(*mated));
+    REQUIRE(is_checkmate(*mated));
+    REQUIRE_FALSE(has_any_legal_move(*stalemated));
+    REQUIRE(is_stalemate(*stalemated));
+    REQUIRE(check_game_result(*stalemated) == DRAW_STALEMATE);
+}
+
+TEST_CASE("is_pseudo_legal matches the pseudo-legal generator")
+{
+    const char *fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "4k3/8/8/8/8/8/8/R3K2r w Q - 0 1",
+        "r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+        "4k3/8/8/8/1b6/8/3P4/R3K2R w KQ - 0 1",
+        "4k3/8/5n2/8/8/8/4r3/R3K2R w KQ - 0 1",
+        "8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+    };
+
+    // Every one of the 65536 encodings, including the malformed ones
+    for (const char *fen : fens)
+    {
+        auto board = parse_fen(fen);
+        MoveList pseudo, legal;
+        generate_pseudo_legal_moves(*board, pseudo);
+        generate_legal_moves(*board, legal);
+        std::vector<bool> is_pseudo(1 << 16), is_legal(1 << 16);
+        for (Move m : pseudo)
+            is_pseudo[m] = true;
+        for (Move m : legal)
+            is_legal[m] = true;
+
+        int pseudo_mismatches = 0, legal_mismatches = 0;
+        for (uint32_t m = 0; m < (1u << 16); ++m)
+        {
+            pseudo_mismatches += is_pseudo_legal(*board, Move(m)) != is_pseudo[m];
+            legal_mismatches += is_legal_move(*board, Move(m)) != is_legal[m];
+        }
+        INFO(fen);
+        REQUIRE(pseudo_mismatches == 0);
+        REQUIRE(legal_mismatches == 0);
+    }
+}
+
+TEST_CASE("Iterative deepening search")
+{
+    SearchLimits limits;
+    limits.max_depth = 4;
+
+    // Back-rank mate in one
+    auto mate = parse_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+    SearchResult result = search(*mate, limits);
+    REQUIRE(move_to_string(*mate, result.best_move) == "d1d8");
+    REQUIRE(result.score == EVAL_CHECKMATE - 1);
+
+    // Free queen
+    auto hanging = parse_fen("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1");
+    result = search(*hanging, limits);
+    REQUIRE(move_to_string(*hanging, result.best_move) == "d1d5");
+
+    // The PV is a legal line starting with the best move and the limits hold
+    BoardState board;
+    init_board(board);
+    result = search(board, limits);
+    REQUIRE(result.depth == 4);
+    REQUIRE(result.nodes_searched > 0);
+    REQUIRE_FALSE(result.principal_variation.empty());
+    REQUIRE(result.principal_variation[0] == result.best_move);
+    BoardState line = board;
+    for (Move m : result.principal_variation)
+    {
+        MoveList legal;
+        generate_legal_moves(line, legal);
+        REQUIRE(std::find(legal.begin(), legal.end(), m) != legal.end());
+        make_move(line, m);
+    }
+
+    limits.max_depth = 64;
+    limits.max_nodes = 20000;
+    result = search(board, limits);
+    REQUIRE(result.nodes_searched < limits.max_nodes + STOP_CHECK_INTERVAL);
+    REQUIRE(result.best_move != MOVE_NONE);
+
+    // Stalemate and checkmate at the root
+    auto stalemated = parse_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    result = search(*stalemated, limits);
+    REQUIRE(result.best_move == MOVE_NONE);
+    REQUIRE(result.score == 0);
+}
+
+TEST_CASE("Transposition table")
+{
+    TranspositionTable tt;
+    tt.resize(1);
+    REQUIRE(tt.mask + 1 == 1024 * 1024 / sizeof(TTBucket));
+    REQUIRE(tt.hashfull() == 0);
+
+    const uint64_t key = 0x123456789ABCDEF0ULL;
+    TTEntry entry;
+    REQUIRE_FALSE(tt.probe(key, entry));
+
+    Move move = make_move(12, 28);
+    tt.store(key, move, -250, 31, 7, BOUND_LOWER);
+    REQUIRE(tt.probe(key, entry));
+    REQUIRE(entry.move == move);
+    REQUIRE(entry.score == -250);
+    REQUIRE(entry.eval == 31);
+    REQUIRE(entry.depth == 7);
+    REQUIRE(entry.bound == BOUND_LOWER);
+
+    // A shallow bound does not replace a deep result of the same search,
+    // and a new result without a move keeps the old one
+    tt.store(key, MOVE_NONE, 0, EVAL_NONE, 2, BOUND_UPPER);
+    REQUIRE(tt.probe(key, entry));
+    REQUIRE(entry.depth == 7);
+    tt.store(key, MOVE_NONE, EVAL_CHECKMATE - 5, EVAL_NONE, 9, BOUND_EXACT);
+    REQUIRE(tt.probe(key, entry));
+    REQUIRE(entry.move == move);
+    REQUIRE(entry.score == EVAL_CHECKMATE - 5);
+    REQUIRE(entry.eval == EVAL_NONE);
+
+    // Same bucket, different key check: no false hit
+    REQUIRE_FALSE(tt.probe(key ^ (1ULL << 63), entry));
+
+    // A torn write fails the key check
+    TTBucket &bucket = tt.buckets[key & tt.mask];
+    for (int i = 0; i < TTBucket::ENTRIES; ++i)
+        bucket.data[i].store(bucket.data[i].load() ^ 0x100, std::memory_order_relaxed);
+    REQUIRE_FALSE(tt.probe(key, entry));
+
+    // Old entries make way for the current search's
+    for (uint64_t i = 0; i < 2000; ++i)
+        tt.store(i * 0x9E3779B97F4A7C15ULL, MOVE_NONE, 0, 0, 1, BOUND_EXACT);
+    int full = tt.hashfull();
+    REQUIRE(full > 0);
+    tt.new_search();
+    REQUIRE(tt.hashfull() == 0);
+
+    // Searching through the table gives the same mate and reuses the entries
+    auto mate = parse_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+    SearchLimits limits;
+    limits.max_depth = 5;
+    MoveStack history;
+    SearchResult first = search(*mate, limits, history, tt);
+    SearchResult second = search(*mate, limits, history, tt);
+    REQUIRE(first.score == EVAL_CHECKMATE - 1);
+    REQUIRE(second.score == first.score);
+    REQUIRE(second.best_move == first.best_move);
+
+    // A table that was never sized gets the default size from search()
+    TranspositionTable fresh;
+    REQUIRE(fresh.hashfull() == 0);
+    SearchResult fresh_result = search(*mate, limits, history, fresh);
+    REQUIRE(fresh.mask + 1 == TranspositionTable::DEFAULT_MB * 1024 * 1024 / sizeof(TTBucket));
+    REQUIRE(fresh_result.score == first.score);
+    REQUIRE(fresh_result.best_move == first.best_move);
+}
+
+TEST_CASE("Lazy SMP search")
+{
+    TranspositionTable tt;
+    tt.resize(1);
+
+    SearchLimits limits;
+    limits.max_depth = 5;
+    limits.threads = 3;
+
+    auto mate = parse_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+    SearchResult result = search(*mate, limits, MoveStack{}, tt);
+    REQUIRE(move_to_string(*mate, result.best_move) == "d1d8");
+    REQUIRE(result.score == EVAL_CHECKMATE - 1);
+
+    // Node totals cover all threads and the node limit stops the helpers too
+    BoardState board;
+    init_board(board);
+    tt.clear();
+    limits.max_depth = 64;
+    limits.max_nodes = 30000;
+    result = search(board, limits, MoveStack{}, tt);
+    REQUIRE(result.nodes_searched >= limits.max_nodes);
+    REQUIRE(result.nodes_searched < limits.max_nodes + limits.threads * STOP_CHECK_INTERVAL);
+    MoveList legal;
+    generate_legal_moves(board, legal);
+    REQUIRE(std::find(legal.begin(), legal.end(), result.best_move) != legal.end());
+}
+
+TEST_CASE("Staged move picker")
+{
+    const char *fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "4k3/1P6/8/8/8/8/6q1/4K2R w K - 0 1",
+        "r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+    };
+    HistoryTable history = {};
+    auto startpos = parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    MoveList foreign;
+    generate_legal_moves(*startpos, foreign);
+
+    for (const char *fen : fens)
+    {
+        auto board = parse_fen(fen);
+        MoveList legal;
+        generate_legal_moves(*board, legal);
+        std::vector<Move> expected(legal.begin(), legal.end());
+        std::sort(expected.begin(), expected.end());
+
+        // Every legal move exactly once, whatever the hash move and killers,
+        // including moves that are illegal here
+        std::vector<Move> candidates(legal.begin(), legal.end());
+        candidates.insert(candidates.end(), foreign.begin(), foreign.end());
+        candidates.push_back(MOVE_NONE);
+        for (size_t i = 0; i < candidates.size(); i += 3)
+        {
+            Move tt_move = candidates[i];
+            std::array<Move, 2> killers = {candidates[(i + 1) % candidates.size()], candidates[(i + 2) % candidates.size()]};
+            MovePicker picker(*board, history, tt_move, killers, candidates[(i + 5) % candidates.size()]);
+
+            std::vector<Move> picked;
+            for (Move m = picker.next(); m != MOVE_NONE; m = picker.next())
+                picked.push_back(m);
+            if (std::find(expected.begin(), expected.end(), tt_move) != expected.end())
+                REQUIRE(picked[0] == tt_move);
+            std::sort(picked.begin(), picked.end());
+            REQUIRE(picked == expected);
+        }
+    }
+
+    // Kiwipete: captures by SEE, killer, history-ordered quiets, losing captures
+    auto kiwipete = parse_fen(fens[0]);
+    Move killer = string_to_move(*kiwipete, "a2a3");
+    history[square_from_str("e1")][square_from_str("g1")] = 500;
+    MovePicker picker(*kiwipete, history, MOVE_NONE, {killer, MOVE_NONE}, MOVE_NONE);
+    std::vector<Move> order;
+    for (Move m = picker.next(); m != MOVE_NONE; m = picker.next())
+        order.push_back(m);
+    auto position = [&](const char *uci)
+    {
+        return std::find(order.begin(), order.end(), string_to_move(*kiwipete, uci)) - order.begin();
+    };
+    REQUIRE(position("e2a6") == 0);                       // bishop takes bishop, SEE even
+    REQUIRE(position("a2a3") > position("d5e6"));         // killer after the good captures
+    REQUIRE(position("a2a3") < position("e1g1"));
+    REQUIRE(position("e1g1") < position("e1f1"));         // history
+    REQUIRE(position("f3f6") > position("e1f1"));         // queen takes defended knight: last group
+    REQUIRE(size_t(position("e5f7")) < order.size());
+
+    // The quiescence picker stops after the captures that do not lose material
+    MovePicker qpicker(*kiwipete, history, MOVE_NONE);
+    size_t captures = 0;
+    for (Move m = qpicker.next(); m != MOVE_NONE; m = qpicker.next())
+    {
+        REQUIRE_FALSE(is_quiet(*kiwipete, m));
+        REQUIRE(see_ge(*kiwipete, m));
+        captures++;
+    }
+    MoveList generated;
+    generate_captures(*kiwipete, generated);
+    REQUIRE(captures == size_t(std::count_if(generated.begin(), generated.end(),
+                                             [&](Move m) { return see_ge(*kiwipete, m); })));
+    REQUIRE(captures < generated.size());
+}
+
+TEST_CASE("Quiescence search")
+{
+    TranspositionTable tt;
+    tt.resize(1);
+    auto ctx = std::make_unique<SearchContext>();
+    ctx->tt = &tt;
+    auto qsearch = [&](const char *fen)
+    {
+        auto board = parse_fen(fen);
+        tt.clear();
+        ctx->history.top = -1;
+        return quiescence_search(*board, *ctx, -EVAL_INFINITY, EVAL_INFINITY);
+    };
+    auto static_eval = [](const char *fen) { return evaluate(*parse_fen(fen)); };
+
+    // Hanging queen is taken, defended pawn is left alone
+    const char *hanging = "4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1";
+    REQUIRE(qsearch(hanging) > static_eval(hanging) + PIECE_VALUES[ROOK]);
+    const char *defended = "4k3/3p4/4p3/8/8/8/8/4QK2 w - - 0 1";
+    REQUIRE(qsearch(defended) == static_eval(defended));
+
+    // Promotions are searched
+    const char *promotion = "4k3/P7/8/8/8/8/8/4K3 w - - 0 1";
+    REQUIRE(qsearch(promotion) > static_eval(promotion) + PIECE_VALUES[ROOK]);
+
+    // In check every evasion is tried, and no evasion is mate
+    REQUIRE(qsearch("r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4") == -EVAL_CHECKMATE);
+    const char *check = "4k3/8/8/8/8/8/3q4/4K3 w - - 0 1";
+    REQUIRE(qsearch(check) > static_eval(check) + PIECE_VALUES[ROOK]);
+
+    // The result is stored at depth 0 and answers the next probe
+    auto board = parse_fen(hanging);
+    tt.clear();
+    int32_t score = quiescence_search(*board, *ctx, -EVAL_INFINITY, EVAL_INFINITY);
+    TTEntry entry;
+    REQUIRE(tt.probe(board->hash, entry));
+    REQUIRE(entry.depth == 0);
+    REQUIRE(entry.score == score);
+    REQUIRE(entry.eval == evaluate(*board));
+    REQUIRE(move_to_string(*board, entry.move) == "d1d5");
+}